@@ -0,0 +1,276 @@
+#include "Base64Codec.h"
+
+#if PLATFORM_CPU_X86_FAMILY && (defined(__SSSE3__) || defined(__AVX__) || (defined(PLATFORM_ALWAYS_HAS_SSE4_1) && PLATFORM_ALWAYS_HAS_SSE4_1))
+#define BASE64_SIMD_SSSE3 1
+#include <tmmintrin.h>
+#else
+#define BASE64_SIMD_SSSE3 0
+#endif
+
+namespace
+{
+	const ANSICHAR EncodingAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	struct FDecodingTable
+	{
+		uint8 Values[256];
+
+		FDecodingTable()
+		{
+			FMemory::Memset(Values, 0xFF, sizeof(Values));
+
+			for (int32 i = 0; i < 64; ++i)
+				Values[static_cast<uint8>(EncodingAlphabet[i])] = static_cast<uint8>(i);
+		}
+
+		static const FDecodingTable& Get()
+		{
+			static const FDecodingTable Table;
+			return Table;
+		}
+	};
+
+	FORCEINLINE uint32 DecodeChar(const FDecodingTable& Table, TCHAR Char)
+	{
+		return static_cast<uint32>(Char) < 256 ? Table.Values[static_cast<uint32>(Char)] : 0xFF;
+	}
+
+#if BASE64_SIMD_SSSE3
+	// Six-bit index extraction and ASCII translation after Mula and Lemire, "Faster Base64 Encoding and Decoding
+	// using AVX2 Instructions". Reads 16 bytes and consumes the first 12.
+	FORCEINLINE __m128i EncodeBlock(const uint8* Source)
+	{
+		__m128i In = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source));
+		In = _mm_shuffle_epi8(In, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+		const __m128i High = _mm_mulhi_epu16(_mm_and_si128(In, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+		const __m128i Low = _mm_mullo_epi16(_mm_and_si128(In, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+		const __m128i Indices = _mm_or_si128(High, Low);
+
+		__m128i Offsets = _mm_subs_epu8(Indices, _mm_set1_epi8(51));
+		const __m128i IsUpper = _mm_cmpgt_epi8(_mm_set1_epi8(26), Indices);
+		Offsets = _mm_or_si128(Offsets, _mm_and_si128(IsUpper, _mm_set1_epi8(13)));
+
+		const __m128i ShiftTable = _mm_setr_epi8(
+			'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+		return _mm_add_epi8(_mm_shuffle_epi8(ShiftTable, Offsets), Indices);
+	}
+
+	// Narrows 16 characters to bytes with signed saturation to 0..0xFF: 0x100-0x7FFF become 0xFF and 0x8000 and up,
+	// read as negative, become 0x00. Neither is in the alphabet, so the decoder rejects both.
+	FORCEINLINE __m128i LoadChars(const TCHAR* Source)
+	{
+		if constexpr (sizeof(TCHAR) == 1)
+		{
+			return _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source));
+		}
+		else
+		{
+			const __m128i Lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source));
+			const __m128i Hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source + 8));
+			return _mm_packus_epi16(Lo, Hi);
+		}
+	}
+
+	FORCEINLINE void StoreChars(TCHAR* Dest, __m128i Chars)
+	{
+		if constexpr (sizeof(TCHAR) == 1)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Dest), Chars);
+		}
+		else
+		{
+			const __m128i Zero = _mm_setzero_si128();
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Dest), _mm_unpacklo_epi8(Chars, Zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Dest + 8), _mm_unpackhi_epi8(Chars, Zero));
+		}
+	}
+
+	// Decodes 16 characters into 12 bytes, returning false if any character is outside the alphabet.
+	FORCEINLINE bool DecodeBlock(__m128i In, uint8* Dest)
+	{
+		const __m128i LowTable = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+		const __m128i HighTable = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		const __m128i RollTable = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+		const __m128i Mask2F = _mm_set1_epi8(0x2F);
+
+		const __m128i HighNibbles = _mm_and_si128(_mm_srli_epi32(In, 4), Mask2F);
+		const __m128i Lo = _mm_shuffle_epi8(LowTable, _mm_and_si128(In, Mask2F));
+		const __m128i Hi = _mm_shuffle_epi8(HighTable, HighNibbles);
+
+		if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(Lo, Hi), _mm_setzero_si128())) != 0)
+			return false;
+
+		const __m128i IsSlash = _mm_cmpeq_epi8(In, Mask2F);
+		const __m128i Roll = _mm_shuffle_epi8(RollTable, _mm_add_epi8(IsSlash, HighNibbles));
+		const __m128i Values = _mm_add_epi8(In, Roll);
+
+		const __m128i Pairs = _mm_maddubs_epi16(Values, _mm_set1_epi32(0x01400140));
+		const __m128i Words = _mm_madd_epi16(Pairs, _mm_set1_epi32(0x00011000));
+		const __m128i Packed = _mm_shuffle_epi8(Words, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(Dest), Packed);
+		const int32 Tail = _mm_cvtsi128_si32(_mm_srli_si128(Packed, 8));
+		FMemory::Memcpy(Dest + 8, &Tail, 4);
+		return true;
+	}
+#endif
+}
+
+int32 FBase64Codec::GetDecodedLength(const TCHAR* Source, int32 Length)
+{
+	if (Length % 4 != 0)
+		return -1;
+
+	int32 NumBytes = Length / 4 * 3;
+
+	if (Length > 0 && Source[Length - 1] == TEXT('='))
+	{
+		--NumBytes;
+
+		if (Source[Length - 2] == TEXT('='))
+			--NumBytes;
+	}
+
+	return NumBytes;
+}
+
+void FBase64Codec::Encode(TArrayView<const uint8> Source, TCHAR* Dest)
+{
+	const uint8* In = Source.GetData();
+	int32 Remaining = Source.Num();
+
+#if BASE64_SIMD_SSSE3
+	while (Remaining >= 16)
+	{
+		StoreChars(Dest, EncodeBlock(In));
+		In += 12;
+		Dest += 16;
+		Remaining -= 12;
+	}
+#endif
+
+	while (Remaining >= 3)
+	{
+		const uint32 Triple = (In[0] << 16) | (In[1] << 8) | In[2];
+		Dest[0] = EncodingAlphabet[(Triple >> 18) & 0x3F];
+		Dest[1] = EncodingAlphabet[(Triple >> 12) & 0x3F];
+		Dest[2] = EncodingAlphabet[(Triple >> 6) & 0x3F];
+		Dest[3] = EncodingAlphabet[Triple & 0x3F];
+		In += 3;
+		Dest += 4;
+		Remaining -= 3;
+	}
+
+	if (Remaining > 0)
+	{
+		const uint32 Triple = (In[0] << 16) | (Remaining > 1 ? In[1] << 8 : 0);
+		Dest[0] = EncodingAlphabet[(Triple >> 18) & 0x3F];
+		Dest[1] = EncodingAlphabet[(Triple >> 12) & 0x3F];
+		Dest[2] = Remaining > 1 ? EncodingAlphabet[(Triple >> 6) & 0x3F] : '=';
+		Dest[3] = '=';
+	}
+}
+
+FString FBase64Codec::Encode(TArrayView<const uint8> Source)
+{
+	FString Result;
+
+	if (Source.Num() == 0)
+		return Result;
+
+	const int32 Length = GetEncodedLength(Source.Num());
+	TArray<TCHAR>& Chars = Result.GetCharArray();
+
+	Chars.SetNumUninitialized(Length + 1);
+	Encode(Source, Chars.GetData());
+	Chars[Length] = TEXT('\0');
+
+	return Result;
+}
+
+bool FBase64Codec::Decode(const TCHAR* Source, int32 Length, uint8* Dest)
+{
+	if (Length % 4 != 0)
+		return false;
+
+	const FDecodingTable& Table = FDecodingTable::Get();
+
+#if BASE64_SIMD_SSSE3
+	// The last quad may carry padding, so it always goes through the scalar path below.
+	while (Length > 16)
+	{
+		if (!DecodeBlock(LoadChars(Source), Dest))
+			return false;
+
+		Source += 16;
+		Dest += 12;
+		Length -= 16;
+	}
+#endif
+
+	while (Length > 4)
+	{
+		const uint32 A = DecodeChar(Table, Source[0]);
+		const uint32 B = DecodeChar(Table, Source[1]);
+		const uint32 C = DecodeChar(Table, Source[2]);
+		const uint32 D = DecodeChar(Table, Source[3]);
+
+		if ((A | B | C | D) & 0x80)
+			return false;
+
+		const uint32 Triple = (A << 18) | (B << 12) | (C << 6) | D;
+		Dest[0] = static_cast<uint8>(Triple >> 16);
+		Dest[1] = static_cast<uint8>(Triple >> 8);
+		Dest[2] = static_cast<uint8>(Triple);
+
+		Source += 4;
+		Dest += 3;
+		Length -= 4;
+	}
+
+	if (Length == 0)
+		return true;
+
+	const int32 Padding = Source[3] == TEXT('=') ? (Source[2] == TEXT('=') ? 2 : 1) : 0;
+	const uint32 A = DecodeChar(Table, Source[0]);
+	const uint32 B = DecodeChar(Table, Source[1]);
+	const uint32 C = Padding < 2 ? DecodeChar(Table, Source[2]) : 0;
+	const uint32 D = Padding < 1 ? DecodeChar(Table, Source[3]) : 0;
+
+	if ((A | B | C | D) & 0x80)
+		return false;
+
+	const uint32 Triple = (A << 18) | (B << 12) | (C << 6) | D;
+	Dest[0] = static_cast<uint8>(Triple >> 16);
+
+	if (Padding < 2)
+		Dest[1] = static_cast<uint8>(Triple >> 8);
+
+	if (Padding < 1)
+		Dest[2] = static_cast<uint8>(Triple);
+
+	return true;
+}
+
+bool FBase64Codec::Decode(const FString& Source, TArray<uint8>& OutDest)
+{
+	OutDest.Reset();
+
+	const int32 DecodedLength = GetDecodedLength(*Source, Source.Len());
+
+	if (DecodedLength < 0)
+		return false;
+
+	OutDest.SetNumUninitialized(DecodedLength);
+
+	if (!Decode(*Source, Source.Len(), OutDest.GetData()))
+	{
+		OutDest.Reset();
+		return false;
+	}
+
+	return true;
+}
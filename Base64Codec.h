@@ -0,0 +1,27 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Standard alphabet Base64 with '=' padding, byte-compatible with FBase64. On x64 builds with SSSE3 the bulk of
+// the input goes through 16-lane kernels; the tail and other targets use the scalar table path.
+class CLIENT_API FBase64Codec
+{
+public:
+	static FORCEINLINE int32 GetEncodedLength(int32 NumBytes)
+	{
+		return ((NumBytes + 2) / 3) * 4;
+	}
+
+	// Returns -1 if Length is not a multiple of four.
+	static int32 GetDecodedLength(const TCHAR* Source, int32 Length);
+
+	// Dest must hold GetEncodedLength(Source.Num()) characters; no terminator is written.
+	static void Encode(TArrayView<const uint8> Source, TCHAR* Dest);
+	static FString Encode(TArrayView<const uint8> Source);
+
+	// Dest must hold GetDecodedLength(Source, Length) bytes. Returns false on malformed input.
+	static bool Decode(const TCHAR* Source, int32 Length, uint8* Dest);
+
+	// Replaces the contents of OutDest, keeping its allocation. OutDest is left empty on malformed input.
+	static bool Decode(const FString& Source, TArray<uint8>& OutDest);
+};
@@ -0,0 +1,88 @@
+#include "BatchEncoder.h"
+#include "QueueBuffer.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+
+UByteBuffer* FBatchEncoder::Encode(uint8 PacketType, int32 NumRecords, FRecordSerializer Serializer, int32 MinRecordsPerChunk)
+{
+	return EncodeChunks(PacketType, NumRecords, Serializer, MinRecordsPerChunk, 0);
+}
+
+UByteBuffer* FBatchEncoder::EncodeWithSchema(uint8 PacketType, const FPacketSchema& Schema, TArrayView<const FDynamicValue> Values, int32 MinRecordsPerChunk)
+{
+	const int32 NumFields = Schema.Fields.Num();
+
+	if (NumFields == 0 || Values.Num() % NumFields != 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("EncodeWithSchema: %d values do not form whole records of %d fields"), Values.Num(), NumFields);
+		return UByteBuffer::CreateByteBufferWithCapacity(0);
+	}
+
+	return EncodeChunks(PacketType, Values.Num() / NumFields, [&Schema, Values, NumFields](int32 RecordIndex, UByteBuffer& Out)
+	{
+		Out.WriteDataWithSchema(Schema, Values.Slice(RecordIndex * NumFields, NumFields));
+	}, MinRecordsPerChunk, Schema.MinSize);
+}
+
+UByteBuffer* FBatchEncoder::EncodeChunks(uint8 PacketType, int32 NumRecords, FRecordSerializer Serializer, int32 MinRecordsPerChunk, int32 EstimatedPayloadSize)
+{
+	check(IsInGameThread());
+
+	if (NumRecords <= 0)
+		return UByteBuffer::CreateByteBufferWithCapacity(0);
+
+	const int32 RecordOverhead = 1 + UQueueBuffer::EndRepeatByte;
+	const int32 MaxChunks = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	const int32 NumChunks = FMath::Clamp(NumRecords / FMath::Max(MinRecordsPerChunk, 1), 1, MaxChunks);
+	const int32 RecordsPerChunk = FMath::DivideAndRoundUp(NumRecords, NumChunks);
+
+	TArray<UByteBuffer*, TInlineAllocator<32>> Chunks;
+	Chunks.Reserve(NumChunks);
+
+	for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+		Chunks.Add(UByteBuffer::CreateByteBufferWithCapacity(RecordsPerChunk * (RecordOverhead + EstimatedPayloadSize)));
+
+	ParallelFor(NumChunks, [&](int32 ChunkIndex)
+	{
+		UByteBuffer& Out = *Chunks[ChunkIndex];
+		const int32 First = ChunkIndex * RecordsPerChunk;
+		const int32 Last = FMath::Min(First + RecordsPerChunk, NumRecords);
+
+		for (int32 RecordIndex = First; RecordIndex < Last; ++RecordIndex)
+		{
+			Out.PutByte(PacketType);
+			Serializer(RecordIndex, Out);
+
+			uint8* Marker = Out.BeginWrite(UQueueBuffer::EndRepeatByte).GetData();
+			FMemory::Memset(Marker, UQueueBuffer::EndOfPacketByte, UQueueBuffer::EndRepeatByte);
+			Out.CommitWrite(UQueueBuffer::EndRepeatByte);
+		}
+	});
+
+	TArray<int32, TInlineAllocator<32>> Offsets;
+	Offsets.SetNumUninitialized(NumChunks);
+
+	int32 TotalSize = 0;
+
+	for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+	{
+		Offsets[ChunkIndex] = TotalSize;
+		TotalSize += Chunks[ChunkIndex]->Length();
+	}
+
+	UByteBuffer* Frame = UByteBuffer::CreateByteBufferWithCapacity(TotalSize);
+	uint8* FrameData = Frame->BeginWrite(TotalSize).GetData();
+
+	ParallelFor(NumChunks, [&](int32 ChunkIndex)
+	{
+		const TArray<uint8>& Chunk = Chunks[ChunkIndex]->GetBuffer();
+		FMemory::Memcpy(FrameData + Offsets[ChunkIndex], Chunk.GetData(), Chunk.Num());
+	});
+
+	Frame->CommitWrite(TotalSize);
+
+	for (UByteBuffer* Chunk : Chunks)
+		Chunk->ReleaseStorage();
+
+	return Frame;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ByteBuffer.h"
+
+// Encodes many records of one packet type in parallel and stitches them into a single frame in the
+// UQueueBuffer combined layout, ready to send with the queue packet type. Records are split into contiguous
+// chunks, each chunk is encoded into its own scratch buffer on a worker, and the chunks are then copied
+// into the final frame at precomputed offsets, so record order is preserved.
+class CLIENT_API FBatchEncoder
+{
+public:
+	// Called concurrently for different records; it must only write the record's payload to Out.
+	using FRecordSerializer = TFunctionRef<void(int32 RecordIndex, UByteBuffer& Out)>;
+
+	static constexpr int32 DefaultMinRecordsPerChunk = 32;
+
+	// Must be called on the game thread, since the scratch and result buffers are UObjects.
+	static UByteBuffer* Encode(uint8 PacketType, int32 NumRecords, FRecordSerializer Serializer, int32 MinRecordsPerChunk = DefaultMinRecordsPerChunk);
+
+	// Values holds Schema.Fields.Num() values per record, record after record.
+	static UByteBuffer* EncodeWithSchema(uint8 PacketType, const FPacketSchema& Schema, TArrayView<const FDynamicValue> Values, int32 MinRecordsPerChunk = DefaultMinRecordsPerChunk);
+
+private:
+	static UByteBuffer* EncodeChunks(uint8 PacketType, int32 NumRecords, FRecordSerializer Serializer, int32 MinRecordsPerChunk, int32 EstimatedPayloadSize);
+};
@@ -0,0 +1,148 @@
+#include "BufferPool.h"
+#include "Misc/ScopeLock.h"
+
+FByteBufferPool& FByteBufferPool::Get()
+{
+	static FByteBufferPool Instance;
+	return Instance;
+}
+
+FByteBufferPool::FThreadCache& FByteBufferPool::GetThreadCache()
+{
+	static thread_local FThreadCache Cache;
+	return Cache;
+}
+
+int32 FByteBufferPool::SizeClassForCapacity(int32 Capacity)
+{
+	if (Capacity <= MinBlockSize)
+		return 0;
+
+	return static_cast<int32>(FMath::CeilLogTwo(static_cast<uint32>(Capacity))) - 7;
+}
+
+int32 FByteBufferPool::SizeClassOfBlock(int32 BlockSize)
+{
+	return static_cast<int32>(FMath::FloorLog2(static_cast<uint32>(BlockSize))) - 7;
+}
+
+int32 FByteBufferPool::SizeOfClass(int32 SizeClass)
+{
+	return MinBlockSize << SizeClass;
+}
+
+int32 FByteBufferPool::MaxSharedBlocks(int32 SizeClass)
+{
+	return FMath::Max(ThreadCacheSize, MaxSharedBytesPerClass / SizeOfClass(SizeClass));
+}
+
+bool FByteBufferPool::FBlockList::Pop(TArray<uint8>& OutBlock)
+{
+	if (Count == 0)
+		return false;
+
+	OutBlock = MoveTemp(Blocks[--Count]);
+	return true;
+}
+
+void FByteBufferPool::FBlockList::Push(TArray<uint8>&& Block)
+{
+	if (Count == Blocks.Num())
+		Blocks.AddDefaulted();
+
+	Blocks[Count++] = MoveTemp(Block);
+}
+
+TArray<uint8> FByteBufferPool::Acquire(int32 MinCapacity)
+{
+	TArray<uint8> Block;
+
+	if (MinCapacity > MaxBlockSize)
+	{
+		Block.Reserve(MinCapacity);
+		return Block;
+	}
+
+	const int32 SizeClass = SizeClassForCapacity(MinCapacity);
+	FThreadCache& Cache = GetThreadCache();
+
+	if (Cache.Counts[SizeClass] > 0)
+		return MoveTemp(Cache.Blocks[SizeClass][--Cache.Counts[SizeClass]]);
+
+	{
+		FScopeLock ScopeLock(&Lock);
+
+		// Refill half of the thread cache at once so the lock is taken once per several acquires.
+		while (Cache.Counts[SizeClass] < ThreadCacheSize / 2 && Shared[SizeClass].Pop(Block))
+			Cache.Blocks[SizeClass][Cache.Counts[SizeClass]++] = MoveTemp(Block);
+	}
+
+	if (Cache.Counts[SizeClass] > 0)
+		return MoveTemp(Cache.Blocks[SizeClass][--Cache.Counts[SizeClass]]);
+
+	Block.Reserve(SizeOfClass(SizeClass));
+	return Block;
+}
+
+void FByteBufferPool::Release(TArray<uint8>&& Storage)
+{
+	const int32 BlockSize = Storage.Max();
+
+	if (BlockSize < MinBlockSize || BlockSize >= MaxBlockSize * 2)
+	{
+		Storage.Empty();
+		return;
+	}
+
+	const int32 SizeClass = FMath::Min(SizeClassOfBlock(BlockSize), NumSizeClasses - 1);
+	FThreadCache& Cache = GetThreadCache();
+
+	Storage.Reset();
+
+	if (Cache.Counts[SizeClass] == ThreadCacheSize)
+	{
+		FScopeLock ScopeLock(&Lock);
+		FBlockList& List = Shared[SizeClass];
+
+		while (Cache.Counts[SizeClass] > ThreadCacheSize / 2)
+		{
+			TArray<uint8>& Spill = Cache.Blocks[SizeClass][--Cache.Counts[SizeClass]];
+
+			if (List.Count < MaxSharedBlocks(SizeClass))
+				List.Push(MoveTemp(Spill));
+			else
+				Spill.Empty();
+		}
+	}
+
+	Cache.Blocks[SizeClass][Cache.Counts[SizeClass]++] = MoveTemp(Storage);
+}
+
+void FByteBufferPool::Grow(TArray<uint8>& Storage, int32 MinCapacity)
+{
+	if (MinCapacity <= Storage.Max())
+		return;
+
+	// Grow at least geometrically so a buffer built field by field reallocates O(log n) times.
+	TArray<uint8> Larger = Acquire(FMath::Max(MinCapacity, Storage.Max() * 2));
+	Larger.Append(Storage);
+	Release(MoveTemp(Storage));
+	Storage = MoveTemp(Larger);
+}
+
+void FByteBufferPool::Prewarm(int32 Capacity, int32 Count)
+{
+	if (Capacity > MaxBlockSize || Count <= 0)
+		return;
+
+	const int32 SizeClass = SizeClassForCapacity(Capacity);
+	FScopeLock ScopeLock(&Lock);
+	FBlockList& List = Shared[SizeClass];
+
+	for (int32 i = 0; i < Count && List.Count < MaxSharedBlocks(SizeClass); ++i)
+	{
+		TArray<uint8> Block;
+		Block.Reserve(SizeOfClass(SizeClass));
+		List.Push(MoveTemp(Block));
+	}
+}
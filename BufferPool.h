@@ -0,0 +1,54 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+// Recycles byte storage in power-of-two size classes from MinBlockSize to MaxBlockSize. Each thread keeps
+// a small cache per class and only touches the shared, locked lists when that cache over- or underflows.
+class CLIENT_API FByteBufferPool
+{
+public:
+	static constexpr int32 MinBlockSize = 128;
+	static constexpr int32 MaxBlockSize = 512 * 1024;
+	static constexpr int32 NumSizeClasses = 13;
+	static constexpr int32 ThreadCacheSize = 8;
+	static constexpr int32 MaxSharedBytesPerClass = 4 * 1024 * 1024;
+
+	static FByteBufferPool& Get();
+
+	// Returns an empty array with at least MinCapacity bytes of capacity.
+	TArray<uint8> Acquire(int32 MinCapacity);
+
+	// Takes back storage of any origin; blocks outside the size classes are simply freed.
+	void Release(TArray<uint8>&& Storage);
+
+	// Moves the contents of Storage into a pooled block of at least MinCapacity bytes.
+	void Grow(TArray<uint8>& Storage, int32 MinCapacity);
+
+	void Prewarm(int32 Capacity, int32 Count);
+
+private:
+	struct FBlockList
+	{
+		TArray<TArray<uint8>> Blocks;
+		int32 Count = 0;
+
+		bool Pop(TArray<uint8>& OutBlock);
+		void Push(TArray<uint8>&& Block);
+	};
+
+	struct FThreadCache
+	{
+		TArray<uint8> Blocks[NumSizeClasses][ThreadCacheSize];
+		int32 Counts[NumSizeClasses] = {};
+	};
+
+	static FThreadCache& GetThreadCache();
+	static int32 SizeClassForCapacity(int32 Capacity);
+	static int32 SizeClassOfBlock(int32 BlockSize);
+	static int32 SizeOfClass(int32 SizeClass);
+	static int32 MaxSharedBlocks(int32 SizeClass);
+
+	FCriticalSection Lock;
+	FBlockList Shared[NumSizeClasses];
+};
@@ -1,42 +1,376 @@
 #include "ByteBuffer.h"
+#include "BufferPool.h"
+#include "NetStringTable.h"
+#include "Websocket.h"
+#include "PacketLog.h"
+#include "Base64Codec.h"
+#include "Utf8Codec.h"
+#include "FrameArena.h"
+#include "Misc/ScopeRWLock.h"
 
 FString IntToBase36(int32 Value) {
-    FString chars = TEXT("0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ");
-    FString result = TEXT("");
+    static const TCHAR Chars[] = TEXT("0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ");
 
     if (Value == 0) 
         return TEXT("0");
-       
+
+    TCHAR Digits[8];
+    int32 Start = UE_ARRAY_COUNT(Digits);
+
     while (Value > 0) {
-        int remainder = Value % 36;
+        Digits[--Start] = Chars[Value % 36];
         Value /= 36;
-        result += chars[remainder];
     }
-    
-    result = result.Reverse();
 
-    return result;
+    return FString(UE_ARRAY_COUNT(Digits) - Start, Digits + Start);
 }
 
 int32 Base36ToInt(const FString& Base36) {
     return FCString::Strtoi(*Base36, nullptr, 36);
 }
 
+struct FPacketSchemaCache
+{
+    static constexpr int32 MaxSchemas = 1024;
+
+    struct FEntry
+    {
+        TMap<FString, FString> DataSequence;
+        TSharedRef<const FPacketSchema> Schema;
+    };
+
+    FRWLock Lock;
+    TMultiMap<uint32, FEntry> Entries;
+
+    static FPacketSchemaCache& Get()
+    {
+        static FPacketSchemaCache Instance;
+        return Instance;
+    }
+
+    static uint32 HashDataSequence(const TMap<FString, FString>& DataSequence)
+    {
+        uint32 Hash = 0;
+
+        for (const TPair<FString, FString>& Elem : DataSequence)
+            Hash = HashCombine(HashCombine(Hash, GetTypeHash(Elem.Key)), GetTypeHash(Elem.Value));
+
+        return Hash;
+    }
+
+    // Field order is part of the schema, so the sequences are compared in iteration order.
+    static bool Matches(const TMap<FString, FString>& A, const TMap<FString, FString>& B)
+    {
+        if (A.Num() != B.Num())
+            return false;
+
+        auto ItB = B.CreateConstIterator();
+
+        for (const TPair<FString, FString>& Elem : A)
+        {
+            if (Elem.Key != ItB->Key || Elem.Value != ItB->Value)
+                return false;
+
+            ++ItB;
+        }
+
+        return true;
+    }
+
+    TSharedRef<const FPacketSchema> FindOrCompile(const TMap<FString, FString>& DataSequence)
+    {
+        const uint32 Hash = HashDataSequence(DataSequence);
+
+        {
+            FReadScopeLock ReadLock(Lock);
+
+            for (auto It = Entries.CreateConstKeyIterator(Hash); It; ++It)
+            {
+                if (Matches(It.Value().DataSequence, DataSequence))
+                    return It.Value().Schema;
+            }
+        }
+
+        TSharedRef<const FPacketSchema> Schema = MakeShared<FPacketSchema>(FPacketSchema::Compile(DataSequence));
+
+        FWriteScopeLock WriteLock(Lock);
+
+        if (Entries.Num() < MaxSchemas)
+            Entries.Add(Hash, FEntry{ DataSequence, Schema });
+
+        return Schema;
+    }
+};
+
+template <typename FuncType>
+void ForEachCombinedPacket(const TArray<uint8>& BufferData, FuncType&& Func)
+{
+    int32 StartPosition = 1; 
+    int32 BufferSize = BufferData.Num();
+
+    for (int32 i = 1; i <= BufferSize - 4; ++i) {
+        if (
+            BufferData[i] == 0xFE && 
+            BufferData[i + 1] == 0xFE && 
+            BufferData[i + 2] == 0xFE && 
+            BufferData[i + 3] == 0xFE
+        ) {
+            if (i > StartPosition)
+                Func(&BufferData[StartPosition], i - StartPosition);
+
+            StartPosition = i + 4;
+            i += 3;
+        }
+    }
+
+    if (StartPosition < BufferSize)
+        Func(&BufferData[StartPosition], BufferSize - StartPosition);
+}
+
+FString FNetId::ToString() const
+{
+    return IntToBase36(Value);
+}
+
+FNetId FNetId::FromString(const FString& Id)
+{
+    return FNetId(Base36ToInt(Id));
+}
+
+FPacketSchema FPacketSchema::Compile(const TMap<FString, FString>& DataSequence)
+{
+    FPacketSchema Schema;
+    Schema.Fields.Reserve(DataSequence.Num());
+
+    for (const TPair<FString, FString>& Elem : DataSequence)
+    {
+        FPacketSchemaField& Field = Schema.Fields.AddDefaulted_GetRef();
+        Field.Key = Elem.Key;
+        Field.ValueType = ParseValueType(Elem.Value);
+    }
+
+    Schema.ComputeLayout();
+
+    return Schema;
+}
+
+void FPacketSchema::ComputeLayout()
+{
+    int32 Offset = 0;
+    bFixedSize = true;
+
+    for (FPacketSchemaField& Field : Fields)
+    {
+        Field.Offset = Offset;
+
+        if (Offset != INDEX_NONE)
+            Offset = (Field.ValueType == EDynamicValueType::String) ? INDEX_NONE : Offset + GetFixedSize(Field.ValueType);
+
+        if (Field.ValueType == EDynamicValueType::String)
+            bFixedSize = false;
+    }
+
+    int32 RemainingMinSize = 0;
+
+    for (int32 i = Fields.Num() - 1; i >= 0; --i)
+    {
+        RemainingMinSize += GetFixedSize(Fields[i].ValueType);
+        Fields[i].RemainingMinSize = RemainingMinSize;
+    }
+
+    MinSize = RemainingMinSize;
+}
+
+EDynamicValueType FPacketSchema::ParseValueType(const FString& TypeName)
+{
+    if (TypeName == FString("id"))
+        return EDynamicValueType::ID;
+    else if (TypeName == FString("int32") || TypeName == FString("int"))
+        return EDynamicValueType::Int32;
+    else if (TypeName == FString("uint32") || TypeName == FString("uint"))
+        return EDynamicValueType::UInt32;
+    else if (TypeName == FString("float"))
+        return EDynamicValueType::Float;
+    else if (TypeName == FString("string") || TypeName == FString("str"))
+        return EDynamicValueType::String;
+    else if (TypeName == FString("byte"))
+        return EDynamicValueType::Byte;
+    else if (TypeName == FString("bool") || TypeName == FString("boolean"))
+        return EDynamicValueType::Bool;
+    else if (TypeName == FString("vector"))
+        return EDynamicValueType::Vector;
+    else if (TypeName == FString("rotator"))
+        return EDynamicValueType::Rotator;
+    else if (TypeName == FString("int16") || TypeName == FString("short"))
+        return EDynamicValueType::Int16;
+    else if (TypeName == FString("int64") || TypeName == FString("long"))
+        return EDynamicValueType::Int64;
+    else if (TypeName == FString("double"))
+        return EDynamicValueType::Double;
+
+    return EDynamicValueType::None;
+}
+
+int32 FPacketSchema::GetFixedSize(EDynamicValueType ValueType)
+{
+    switch (ValueType)
+    {
+    case EDynamicValueType::ID:
+    case EDynamicValueType::Int32:
+    case EDynamicValueType::UInt32:
+    case EDynamicValueType::Float:
+    case EDynamicValueType::String:
+        return 4;
+    case EDynamicValueType::Byte:
+    case EDynamicValueType::Bool:
+        return 1;
+    case EDynamicValueType::Int16:
+        return 2;
+    case EDynamicValueType::Int64:
+    case EDynamicValueType::Double:
+        return 8;
+    case EDynamicValueType::Vector:
+    case EDynamicValueType::Rotator:
+        return 12;
+    default:
+        return 0;
+    }
+}
+
+TSharedRef<const FPacketSchema> FPacketSchema::FindOrCompile(const TMap<FString, FString>& DataSequence)
+{
+    return FPacketSchemaCache::Get().FindOrCompile(DataSequence);
+}
+
+int32 FPacketSchema::FindField(const FString& Key) const
+{
+    return Fields.IndexOfByPredicate([&Key](const FPacketSchemaField& Field) { return Field.Key == Key; });
+}
+
+int32 FPacketSchema::FindFieldOffsets(const uint8* Record, int32 Size, int32* OutOffsets) const
+{
+    const int32 NumFields = Fields.Num();
+    int32 Position = 0;
+
+    for (int32 i = 0; i < NumFields; ++i)
+    {
+        const FPacketSchemaField& Field = Fields[i];
+        OutOffsets[i] = Position;
+
+        if (Field.ValueType != EDynamicValueType::String)
+        {
+            Position += GetFixedSize(Field.ValueType);
+            continue;
+        }
+
+        const int32 Length = ByteBufferDetail::Load<int32>(Record + Position);
+        const int32 TailMinSize = (i + 1 < NumFields) ? Fields[i + 1].RemainingMinSize : 0;
+        Position += 4;
+
+        if (Length < 0 || Size - Position - TailMinSize < Length)
+            return INDEX_NONE;
+
+        Position += Length;
+    }
+
+    return Position;
+}
+
 void UBufferData::Initialize(const TMap<FString, FDynamicValue>& InputData)
 {
     Data = InputData;
+    LazySchema.Reset();
+}
+
+void UBufferData::Initialize(TMap<FString, FDynamicValue>&& InputData)
+{
+    Data = MoveTemp(InputData);
+    LazySchema.Reset();
+}
+
+void UBufferData::InitializeLazy(const TSharedRef<const FPacketSchema>& InSchema, TArrayView<const uint8> Record, TArray<int32>&& FieldOffsets)
+{
+    Data.Reset();
+    LazySchema = InSchema;
+    LazyBytes.Reset(Record.Num());
+    LazyBytes.Append(Record.GetData(), Record.Num());
+    LazyOffsets = MoveTemp(FieldOffsets);
+}
+
+const uint8* UBufferData::FindLazyField(const FString& Key, EDynamicValueType& OutValueType) const
+{
+    if (!LazySchema.IsValid())
+        return nullptr;
+
+    const int32 FieldIndex = LazySchema->FindField(Key);
+
+    if (FieldIndex == INDEX_NONE)
+        return nullptr;
+
+    OutValueType = LazySchema->Fields[FieldIndex].ValueType;
+    return LazyBytes.GetData() + LazyOffsets[FieldIndex];
 }
 
 FString UBufferData::GetId(FString Key) const {
+    return GetIdRef(Key);
+}
+
+static const FString EmptyString;
+
+// Decoding only stores the integer; the Base36 string is built on first access and kept in the value.
+const FString& UBufferData::GetIdRef(const FString& Key) const
+{
+    FDynamicValue* Value = Data.Find(Key);
+
+    if (!Value)
+    {
+        EDynamicValueType ValueType;
+        const uint8* Field = FindLazyField(Key, ValueType);
+
+        if (!Field || ValueType != EDynamicValueType::ID)
+            return EmptyString;
+
+        Value = &Data.Add(Key);
+        Value->ValueType = EDynamicValueType::ID;
+        Value->IntValue = ByteBufferDetail::Load<int32>(Field);
+    }
+
+    if (Value->ValueType != EDynamicValueType::ID)
+        return EmptyString;
+
+    if (Value->StringValue.IsEmpty())
+        Value->StringValue = FNetId(Value->IntValue).ToString();
+
+    return Value->StringValue;
+}
+
+FNetId UBufferData::GetNetId(const FString& Key) const {
+    EDynamicValueType ValueType;
+
+    if (const uint8* Field = FindLazyField(Key, ValueType))
+        return ValueType == EDynamicValueType::ID ? FNetId(ByteBufferDetail::Load<int32>(Field)) : FNetId();
+
     const FDynamicValue* Value = Data.Find(Key);
 
     if (Value && Value->ValueType == EDynamicValueType::ID)
-        return Value->StringValue;
-    else
-        return FString();
+        return FNetId(Value->IntValue);
+
+    return FNetId();
 }
 
 FString UBufferData::GetString(FString Key) const {
+    EDynamicValueType ValueType;
+
+    if (const uint8* Field = FindLazyField(Key, ValueType))
+    {
+        FString Value;
+
+        if (ValueType == EDynamicValueType::String)
+            FUtf8Codec::DecodeToString(Field + 4, ByteBufferDetail::Load<int32>(Field), Value);
+
+        return Value;
+    }
+
     const FDynamicValue* Value = Data.Find(Key);
 
     if (Value && Value->ValueType == EDynamicValueType::String)
@@ -46,6 +380,11 @@ FString UBufferData::GetString(FString Key) const {
 }
 
 bool UBufferData::GetBool(const FString& Key) const {
+    EDynamicValueType ValueType;
+
+    if (const uint8* Field = FindLazyField(Key, ValueType))
+        return ValueType == EDynamicValueType::Bool && ByteBufferDetail::Load<bool>(Field);
+
     const FDynamicValue* Value = Data.Find(Key);
 
     if (Value && Value->ValueType == EDynamicValueType::Bool)
@@ -55,15 +394,46 @@ bool UBufferData::GetBool(const FString& Key) const {
 }
 
 int32 UBufferData::GetInt32(const FString& Key) const {
+    EDynamicValueType ValueType;
+
+    if (const uint8* Field = FindLazyField(Key, ValueType))
+    {
+        if (ValueType == EDynamicValueType::Int32)
+            return ByteBufferDetail::Load<int32>(Field);
+        else if (ValueType == EDynamicValueType::Int16)
+            return ByteBufferDetail::Load<int16>(Field);
+
+        return 0;
+    }
+
     const FDynamicValue* Value = Data.Find(Key);
 
-    if (Value && Value->ValueType == EDynamicValueType::Int32)
+    if (Value && (Value->ValueType == EDynamicValueType::Int32 || Value->ValueType == EDynamicValueType::Int16))
         return Value->IntValue;
 
     return 0;
 }
 
+int64 UBufferData::GetInt64(const FString& Key) const {
+    EDynamicValueType ValueType;
+
+    if (const uint8* Field = FindLazyField(Key, ValueType))
+        return ValueType == EDynamicValueType::Int64 ? ByteBufferDetail::Load<int64>(Field) : 0;
+
+    const FDynamicValue* Value = Data.Find(Key);
+
+    if (Value && Value->ValueType == EDynamicValueType::Int64)
+        return Value->Int64Value;
+
+    return 0;
+}
+
 uint32 UBufferData::GetUInt32(const FString& Key) const {
+    EDynamicValueType ValueType;
+
+    if (const uint8* Field = FindLazyField(Key, ValueType))
+        return ValueType == EDynamicValueType::UInt32 ? ByteBufferDetail::Load<uint32>(Field) : 0;
+
     const FDynamicValue* Value = Data.Find(Key);
 
     if (Value && Value->ValueType == EDynamicValueType::UInt32)
@@ -73,6 +443,11 @@ uint32 UBufferData::GetUInt32(const FString& Key) const {
 }
 
 float UBufferData::GetFloat(const FString& Key) const {
+    EDynamicValueType ValueType;
+
+    if (const uint8* Field = FindLazyField(Key, ValueType))
+        return ValueType == EDynamicValueType::Float ? ByteBufferDetail::Load<float>(Field) : 0.0f;
+
     const FDynamicValue* Value = Data.Find(Key);
 
     if (Value && Value->ValueType == EDynamicValueType::Float)
@@ -81,7 +456,26 @@ float UBufferData::GetFloat(const FString& Key) const {
     return 0.0;
 }
 
+double UBufferData::GetDouble(const FString& Key) const {
+    EDynamicValueType ValueType;
+
+    if (const uint8* Field = FindLazyField(Key, ValueType))
+        return ValueType == EDynamicValueType::Double ? ByteBufferDetail::Load<double>(Field) : 0.0;
+
+    const FDynamicValue* Value = Data.Find(Key);
+
+    if (Value && Value->ValueType == EDynamicValueType::Double)
+        return Value->DoubleValue;
+
+    return 0.0;
+}
+
 uint8 UBufferData::GetByte(const FString& Key) const {
+    EDynamicValueType ValueType;
+
+    if (const uint8* Field = FindLazyField(Key, ValueType))
+        return ValueType == EDynamicValueType::Byte ? *Field : 0;
+
     const FDynamicValue* Value = Data.Find(Key);
 
     if (Value && Value->ValueType == EDynamicValueType::Byte)
@@ -91,6 +485,16 @@ uint8 UBufferData::GetByte(const FString& Key) const {
 }
 
 FVector UBufferData::GetVector(const FString& Key) const {
+    EDynamicValueType ValueType;
+
+    if (const uint8* Field = FindLazyField(Key, ValueType))
+    {
+        if (ValueType != EDynamicValueType::Vector)
+            return FVector(0, 0, 0);
+
+        return FVector(ByteBufferDetail::Load<float>(Field), ByteBufferDetail::Load<float>(Field + 4), ByteBufferDetail::Load<float>(Field + 8));
+    }
+
     const FDynamicValue* Value = Data.Find(Key);
 
     if (Value && Value->ValueType == EDynamicValueType::Vector)
@@ -100,6 +504,16 @@ FVector UBufferData::GetVector(const FString& Key) const {
 }
 
 FRotator UBufferData::GetRotator(const FString& Key) const {
+    EDynamicValueType ValueType;
+
+    if (const uint8* Field = FindLazyField(Key, ValueType))
+    {
+        if (ValueType != EDynamicValueType::Rotator)
+            return FRotator(0, 0, 0);
+
+        return FRotator(ByteBufferDetail::Load<float>(Field), ByteBufferDetail::Load<float>(Field + 4), ByteBufferDetail::Load<float>(Field + 8));
+    }
+
     const FDynamicValue* Value = Data.Find(Key);
 
     if (Value && Value->ValueType == EDynamicValueType::Rotator)
@@ -110,349 +524,772 @@ FRotator UBufferData::GetRotator(const FString& Key) const {
 
 void UByteBuffer::EnsureCapacity(int32 RequiredBytes)
 {
-    int32 RequiredCapacity = Position + RequiredBytes;
+    int32 RequiredCapacity = Buffer.Num() + RequiredBytes;
 
     if (RequiredCapacity > Buffer.Max())
-        Buffer.Reserve(RequiredCapacity);
+        FByteBufferPool::Get().Grow(Buffer, RequiredCapacity);
+}
+
+void UByteBuffer::ReleaseStorage()
+{
+    FByteBufferPool::Get().Release(MoveTemp(Buffer));
+    Buffer = TArray<uint8>();
+    Position = 0;
+    InternSites.Reset();
+    InternTable.Reset();
+}
+
+void UByteBuffer::BeginDestroy()
+{
+    ReleaseStorage();
+    Super::BeginDestroy();
 }
 
 UByteBuffer* UByteBuffer::CreateEmptyByteBuffer()
+{
+    return CreateByteBufferWithCapacity(FByteBufferPool::MinBlockSize);
+}
+
+UByteBuffer* UByteBuffer::CreateByteBufferWithCapacity(int32 Capacity)
 {
     UByteBuffer* ByteBuffer = NewObject<UByteBuffer>();
-    ByteBuffer->Buffer = TArray<uint8>();
+    ByteBuffer->Buffer = FByteBufferPool::Get().Acquire(Capacity);
     ByteBuffer->Position = 0;
     return ByteBuffer;
 }
 
-UByteBuffer* UByteBuffer::CreateByteBuffer(const TArray<uint8>& Data = TArray<uint8>())
+UByteBuffer* UByteBuffer::CreateByteBufferFromBytes(const uint8* Data, int32 Size)
 {
-    UByteBuffer* ByteBuffer = NewObject<UByteBuffer>();
-    ByteBuffer->Buffer = Data;
-    ByteBuffer->Position = 0;
+    UByteBuffer* ByteBuffer = CreateByteBufferWithCapacity(Size);
+    ByteBuffer->Buffer.Append(Data, Size);
     return ByteBuffer;
 }
 
+UByteBuffer* UByteBuffer::CreateByteBuffer(const TArray<uint8>& Data = TArray<uint8>())
+{
+    return CreateByteBufferFromBytes(Data.GetData(), Data.Num());
+}
+
 UByteBuffer* UByteBuffer::CreateByteBufferFromString(const FString& Base64Data)
 {
-    UByteBuffer* ByteBuffer = NewObject<UByteBuffer>();
+    const int32 DecodedLength = FBase64Codec::GetDecodedLength(*Base64Data, Base64Data.Len());
+    UByteBuffer* ByteBuffer = CreateByteBufferWithCapacity(FMath::Max(DecodedLength, 0));
+
+    if (!FBase64Codec::Decode(Base64Data, ByteBuffer->Buffer))
+        UE_LOG(LogTemp, Error, TEXT("CreateByteBufferFromString: input is not valid Base64"));
+
+    return ByteBuffer;
+}
+
+FString UByteBuffer::GetId()
+{
+    return GetNetId().ToString();
+}
+
+UByteBuffer* UByteBuffer::PutId(const FString& Id)
+{
+    return PutNetId(FNetId::FromString(Id));
+}
+
+UByteBuffer* UByteBuffer::PutNetId(FNetId Id)
+{
+    return PutInt32(Id.Value);
+}
+
+FNetId UByteBuffer::GetNetId()
+{
+    return FNetId(GetInt32());
+}
+
+FString UByteBuffer::NetIdToString(FNetId Id)
+{
+    return Id.ToString();
+}
+
+FNetId UByteBuffer::StringToNetId(const FString& Id)
+{
+    return FNetId::FromString(Id);
+}
+
+TArrayView<uint8> UByteBuffer::BeginWrite(int32 MaxBytes)
+{
+    EnsureCapacity(MaxBytes);
+    return TArrayView<uint8>(Buffer.GetData() + Buffer.Num(), MaxBytes);
+}
+
+void UByteBuffer::CommitWrite(int32 BytesWritten)
+{
+    check(BytesWritten >= 0 && Buffer.Num() + BytesWritten <= Buffer.Max());
+
+    // The bytes were written into reserved capacity, so growing Num() keeps them in place.
+    Buffer.AddUninitialized(BytesWritten);
+    Position += BytesWritten;
+}
+
+TArrayView<const uint8> UByteBuffer::BeginRead(int32 Bytes) const
+{
+    if (Bytes < 0 || Remaining() < Bytes)
+        return TArrayView<const uint8>();
+
+    return TArrayView<const uint8>(Buffer.GetData() + Position, Bytes);
+}
+
+void UByteBuffer::CommitRead(int32 BytesRead)
+{
+    check(BytesRead >= 0 && BytesRead <= Remaining());
+    Position += BytesRead;
+}
 
-    TArray<uint8> DecodedData;
-    FBase64::Decode(Base64Data, DecodedData);
+UByteBuffer* UByteBuffer::PutBytes(TArrayView<const uint8> Bytes)
+{
+    TArrayView<uint8> Out = BeginWrite(Bytes.Num());
+    FMemory::Memcpy(Out.GetData(), Bytes.GetData(), Bytes.Num());
+    CommitWrite(Bytes.Num());
+    return this;
+}
+
+UByteBuffer* UByteBuffer::PutInt32(int32 Value)
+{
+    return Put<int32>(Value);
+}
+
+UByteBuffer* UByteBuffer::PutUInt32(uint32 Value)
+{
+    return Put<uint32>(Value);
+}
+
+UByteBuffer* UByteBuffer::PutInt16(int32 Value)
+{
+    return Put<int16>(static_cast<int16>(Value));
+}
+
+int32 UByteBuffer::GetInt16()
+{
+    return Get<int16>();
+}
+
+UByteBuffer* UByteBuffer::PutInt64(int64 Value)
+{
+    return Put<int64>(Value);
+}
+
+int64 UByteBuffer::GetInt64()
+{
+    return Get<int64>();
+}
+
+UByteBuffer* UByteBuffer::PutDouble(double Value)
+{
+    return Put<double>(Value);
+}
+
+double UByteBuffer::GetDouble()
+{
+    return Get<double>();
+}
+
+void UByteBuffer::LogReadOverflow() const
+{
+    UE_LOG(LogTemp, Error, TEXT("Attempted to read beyond buffer bounds: Position=%d, BufferSize=%d"), Position, Buffer.Num());
+}
+
+int32 UByteBuffer::GetInt32()
+{
+    int32 Value = 0;
+
+    if (!TryGetInt32(Value))
+        UE_LOG(LogTemp, Error, TEXT("Error packet %d"), Packet);
+
+    return Value;
+}
+
+uint32 UByteBuffer::GetUInt32()
+{
+    uint32 Value = 0;
+
+    if (!TryGetUInt32(Value))
+        UE_LOG(LogTemp, Error, TEXT("Attempted to read beyond buffer bounds: Position=%d, BufferSize=%d"), Position, Buffer.Num());
+
+    return Value;
+}
+
+UByteBuffer* UByteBuffer::PutByte(uint8 Value)
+{
+    return Put<uint8>(Value);
+}
+
+uint8 UByteBuffer::GetByte()
+{
+    uint8 Value = 0;
+
+    if (!TryGetByte(Value))
+        UE_LOG(LogTemp, Error, TEXT("Attempted to read beyond buffer bounds: Position=%d, BufferSize=%d"), Position, Buffer.Num());
+
+    return Value;
+}
+
+UByteBuffer* UByteBuffer::PutString(const FString& Value)
+{
+    uint8* Out = BeginWrite(4 + FUtf8Codec::GetMaxEncodedLength(Value.Len())).GetData();
+    const int32 Length = FUtf8Codec::Encode(*Value, Value.Len(), Out + 4);
+
+    ByteBufferDetail::Store<int32>(Out, Length);
+    CommitWrite(4 + Length);
+
+    return this;
+}
+
+FString UByteBuffer::GetString()
+{
+    int32 Length = GetInt32();
+
+    if (Length > 0 && Position + Length <= Buffer.Num())
+        return ReadStringUnchecked(Length);
+
+    return FString();
+}
+
+UByteBuffer* UByteBuffer::PutVarUInt32(uint32 Value)
+{
+    uint8* Out = BeginWrite(5).GetData();
+    int32 Count = 0;
+
+    while (Value >= 0x80)
+    {
+        Out[Count++] = static_cast<uint8>(Value | 0x80);
+        Value >>= 7;
+    }
 
-    ByteBuffer->Buffer = DecodedData;
-    ByteBuffer->Position = 0;
+    Out[Count++] = static_cast<uint8>(Value);
+    CommitWrite(Count);
 
-    return ByteBuffer;
+    return this;
 }
 
-FString UByteBuffer::GetId()
+bool UByteBuffer::TryGetVarUInt32(uint32& OutValue)
 {
-    int32 IdValue = GetInt32();
-    FString value = IntToBase36(IdValue);
-        
-    return value;
-}
+    uint32 Value = 0;
 
-UByteBuffer* UByteBuffer::PutId(const FString& Id)
-{
-    int32 IdValue = Base36ToInt(Id);
-    return PutInt32(IdValue);
-}
+    for (int32 i = 0; i < 5; ++i)
+    {
+        uint8 Byte = 0;
 
-UByteBuffer* UByteBuffer::PutInt32(int32 Value)
-{
-    EnsureCapacity(4);
+        if (!TryGetByte(Byte))
+        {
+            Position -= i;
+            return false;
+        }
 
-    Buffer.Add(Value & 0xFF);              
-    Buffer.Add((Value >> 8) & 0xFF);        
-    Buffer.Add((Value >> 16) & 0xFF);       
-    Buffer.Add((Value >> 24) & 0xFF);       
+        Value |= static_cast<uint32>(Byte & 0x7F) << (7 * i);
 
-    Position += 4;
+        if ((Byte & 0x80) == 0)
+        {
+            OutValue = Value;
+            return true;
+        }
+    }
 
-    return this;
+    Position -= 5;
+    return false;
 }
 
-UByteBuffer* UByteBuffer::PutUInt32(uint32 Value)
+// Interned strings are a varint tag followed, for literals, by the regular string encoding. A reference is
+// slot << 1; a literal is (slot + 1) << 1 | 1, where slot + 1 == 0 marks a literal the peer must not cache.
+UByteBuffer* UByteBuffer::WriteInternedString(const FString& Value, const TSharedPtr<FNetStringTable>& Table)
 {
-    EnsureCapacity(4);
+    if (InternTable != Table)
+    {
+        InternSites.Reset();
+        InternTable = Table;
+    }
 
-    Buffer.Add(Value & 0xFF);
-    Buffer.Add((Value >> 8) & 0xFF);
-    Buffer.Add((Value >> 16) & 0xFF);
-    Buffer.Add((Value >> 24) & 0xFF);
+    FInternSite& Site = InternSites.AddDefaulted_GetRef();
+    Site.Offset = Buffer.Num();
+    Site.Value = Value;
 
-    Position += 4;
+    PutVarUInt32(1);
+    PutString(Value);
 
+    Site.Size = Buffer.Num() - Site.Offset;
     return this;
 }
 
-int32 UByteBuffer::GetInt32()
+static void AppendVarUInt32(TArray<uint8>& Out, uint32 Value)
 {
-    if (Buffer.Num() >= Position + 4) {
-        int32 result = 0;
+    while (Value >= 0x80)
+    {
+        Out.Add(static_cast<uint8>(Value | 0x80));
+        Value >>= 7;
+    }
 
-        result |= static_cast<int32>(Buffer[Position]) << 0;
-        result |= static_cast<int32>(Buffer[Position + 1]) << 8;
-        result |= static_cast<int32>(Buffer[Position + 2]) << 16;
-        result |= static_cast<int32>(Buffer[Position + 3]) << 24;
+    Out.Add(static_cast<uint8>(Value));
+}
 
-        Position += 4;
+void UByteBuffer::CommitInternedStrings(const TSharedPtr<FNetStringTable>& Table)
+{
+    if (InternSites.Num() == 0)
+        return;
+
+    bool bValid = Table.IsValid() && Table == InternTable;
+    int32 End = 0;
 
-        return result;
+    // Storage edited behind our back leaves the literals as they are rather than splicing into the wrong bytes.
+    for (int32 i = 0; bValid && i < InternSites.Num(); ++i)
+    {
+        const FInternSite& Site = InternSites[i];
+        bValid = Site.Offset >= End && Site.Offset + Site.Size <= Buffer.Num() && Buffer[Site.Offset] == 1;
+        End = Site.Offset + Site.Size;
     }
-    else {
-        UE_LOG(LogTemp, Error, TEXT("Error packet %d"), Packet);
-        return 0;
+
+    if (bValid)
+    {
+        TArray<uint8> Committed = FByteBufferPool::Get().Acquire(Buffer.Num() + InternSites.Num() * 4);
+        int32 Copied = 0;
+
+        for (const FInternSite& Site : InternSites)
+        {
+            Committed.Append(Buffer.GetData() + Copied, Site.Offset - Copied);
+
+            bool bKnown = false;
+            const uint32 Index = static_cast<uint32>(Table->FindOrAssign(Site.Value, bKnown));
+
+            if (bKnown)
+            {
+                AppendVarUInt32(Committed, Index << 1);
+            }
+            else
+            {
+                AppendVarUInt32(Committed, ((Index + 1) << 1) | 1);
+                Committed.Append(Buffer.GetData() + Site.Offset + 1, Site.Size - 1);
+            }
+
+            Copied = Site.Offset + Site.Size;
+        }
+
+        Committed.Append(Buffer.GetData() + Copied, Buffer.Num() - Copied);
+
+        FByteBufferPool::Get().Release(MoveTemp(Buffer));
+        Buffer = MoveTemp(Committed);
+        Position = FMath::Min(Position, Buffer.Num());
     }
+
+    InternSites.Reset();
+    InternTable.Reset();
 }
 
-uint32 UByteBuffer::GetUInt32()
+bool UByteBuffer::TryReadInternedString(FNetStringTable& Table, FString& OutValue)
 {
-    if (Position + 4 > Buffer.Num()) {
-        UE_LOG(LogTemp, Error, TEXT("Attempted to read beyond buffer bounds: Position=%d, BufferSize=%d"), Position, Buffer.Num());
-        return 0; 
-    }
+    const int32 Start = Position;
+    uint32 Tag = 0;
 
-    uint32 result = 0;
+    if (!TryGetVarUInt32(Tag))
+        return false;
 
-    result |= static_cast<uint32>(Buffer[Position]) << 0;
-    result |= static_cast<uint32>(Buffer[Position + 1]) << 8;
-    result |= static_cast<uint32>(Buffer[Position + 2]) << 16;
-    result |= static_cast<uint32>(Buffer[Position + 3]) << 24;
+    const int32 Index = static_cast<int32>(Tag >> 1);
 
-    Position += 4;
+    if (Tag & 1)
+    {
+        FString Literal;
 
-    return result;
-}
+        if (!TryGetString(Literal) || (Index > 0 && !Table.Store(Index - 1, Literal)))
+        {
+            Position = Start;
+            return false;
+        }
 
-UByteBuffer* UByteBuffer::PutByte(uint8 Value)
-{
-    EnsureCapacity(1);
-    Buffer.Add(Value);
-    Position += 1;
-    return this;
-}
+        OutValue = MoveTemp(Literal);
+        return true;
+    }
 
-uint8 UByteBuffer::GetByte()
-{
-    if (Position >= Buffer.Num()) {
-        UE_LOG(LogTemp, Error, TEXT("Attempted to read beyond buffer bounds: Position=%d, BufferSize=%d"), Position, Buffer.Num());
-        return 0; 
+    if (!Table.Find(Index, OutValue))
+    {
+        Position = Start;
+        return false;
     }
 
-    uint8 Value = Buffer[Position];
-    Position += 1;
-    return Value;
+    return true;
 }
 
-UByteBuffer* UByteBuffer::PutString(const FString& Value)
+UByteBuffer* UByteBuffer::PutInternedString(const FString& Value, UWebSocket* Connection)
 {
-    FTCHARToUTF8 Convert(*Value); 
-    int32 Length = Convert.Length();
-    EnsureCapacity(4 + Length); 
-    PutInt32(Length);
-
-    for (int32 i = 0; i < Length; ++i)    
-        PutByte((uint8)Convert.Get()[i]);
-
-    return this;
+    TSharedPtr<FNetStringTable> Table = Connection ? Connection->GetOutgoingStringTable() : TSharedPtr<FNetStringTable>();
+    return Table ? WriteInternedString(Value, Table) : PutString(Value);
 }
 
-FString UByteBuffer::GetString()
+FString UByteBuffer::GetInternedString(UWebSocket* Connection)
 {
-    int32 Length = GetInt32();
+    TSharedPtr<FNetStringTable> Table = Connection ? Connection->GetIncomingStringTable() : TSharedPtr<FNetStringTable>();
 
-    if (Length > 0 && Position + Length <= Buffer.Num())
-    {
-        TArray<uint8> StringBytes;
-        StringBytes.Append(&Buffer[Position], Length);
-        
-        Position += Length;
+    if (!Table)
+        return GetString();
 
-        FString Result = FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(StringBytes.GetData()), StringBytes.Num()));
+    FString Value;
 
-        return Result;
-    }
+    if (!TryReadInternedString(*Table, Value))
+        UE_LOG(LogTemp, Error, TEXT("Invalid interned string in packet %d: Position=%d, BufferSize=%d"), Packet, Position, Buffer.Num());
 
-    return FString();
+    return Value;
 }
 
 UByteBuffer* UByteBuffer::PutFloat(float Value) {
-    EnsureCapacity(sizeof(float));
-    FMemory::Memcpy(Buffer.GetData() + Position, &Value, sizeof(float));
-    Position += sizeof(float);
-    return this;
+    return Put<float>(Value);
 }
 
 float UByteBuffer::GetFloat() {
-    if (Position + sizeof(float) > Buffer.Num()) {
+    float Value = 0.0f;
+
+    if (!TryGetFloat(Value))
         UE_LOG(LogTemp, Error, TEXT("Attempted to read beyond buffer bounds: Position=%d, BufferSize=%d"), Position, Buffer.Num());
-        return 0.0f; 
-    }
 
-    if (Position + sizeof(float) > Buffer.Num()) 
-        return 0.0f;
-    
-    float Value;
-    FMemory::Memcpy(&Value, Buffer.GetData() + Position, sizeof(float));
-    Position += sizeof(float);
     return Value;
 }
 
 UByteBuffer* UByteBuffer::PutBool(bool Value)
 {
-    EnsureCapacity(1);
-    uint8 ByteValue = Value ? 1 : 0;
-    Buffer.Add(ByteValue);
-    Position += 1;
-    return this;
+    return Put<bool>(Value);
 }
 
 bool UByteBuffer::GetBool()
 {
-    if (Position + 1 > Buffer.Num())
-        return false;
-    
-    bool Value = Buffer[Position] != 0;
-    Position += 1;
+    bool Value = false;
+    TryGetBool(Value);
     return Value;
 }
 
 UByteBuffer* UByteBuffer::PutVector(const FVector& Value)
 {
-    PutFloat(Value.X);
-    PutFloat(Value.Y);
-    PutFloat(Value.Z);
+    uint8* Out = BeginWrite(12).GetData();
+    ByteBufferDetail::Store<float>(Out, static_cast<float>(Value.X));
+    ByteBufferDetail::Store<float>(Out + 4, static_cast<float>(Value.Y));
+    ByteBufferDetail::Store<float>(Out + 8, static_cast<float>(Value.Z));
+    CommitWrite(12);
     return this;
 }
 
 FVector UByteBuffer::GetVector()
 {
-    FVector Value;
-    Value.X = GetFloat();
-    Value.Y = GetFloat();
-    Value.Z = GetFloat();
+    FVector Value(0, 0, 0);
+
+    if (!TryGetVector(Value))
+        UE_LOG(LogTemp, Error, TEXT("Attempted to read beyond buffer bounds: Position=%d, BufferSize=%d"), Position, Buffer.Num());
+
     return Value;
 }
 
 UByteBuffer* UByteBuffer::PutRotator(const FRotator& Value)
 {
-    PutFloat(Value.Pitch);
-    PutFloat(Value.Yaw);
-    PutFloat(Value.Roll);
+    uint8* Out = BeginWrite(12).GetData();
+    ByteBufferDetail::Store<float>(Out, static_cast<float>(Value.Pitch));
+    ByteBufferDetail::Store<float>(Out + 4, static_cast<float>(Value.Yaw));
+    ByteBufferDetail::Store<float>(Out + 8, static_cast<float>(Value.Roll));
+    CommitWrite(12);
     return this;
 }
 
 FRotator UByteBuffer::GetRotator()
 {
-    FRotator Value;
-    Value.Pitch = GetFloat();
-    Value.Yaw = GetFloat();
-    Value.Roll = GetFloat();
+    FRotator Value(0, 0, 0);
+
+    if (!TryGetRotator(Value))
+        UE_LOG(LogTemp, Error, TEXT("Attempted to read beyond buffer bounds: Position=%d, BufferSize=%d"), Position, Buffer.Num());
+
     return Value;
 }
 
-bool UByteBuffer::ReadDataFromBuffer(const TMap<FString, FString>& DataSequence, UBufferData*& OutValues, uint8 PacketID)
+int32 UByteBuffer::Remaining() const
 {
-    TMap<FString, FDynamicValue> Values;
-    Values.Empty();
-    Packet = PacketID;
+    return Buffer.Num() - Position;
+}
 
-    for (const TPair<FString, FString>& Elem : DataSequence)
+FString UByteBuffer::ReadStringUnchecked(int32 ByteLength)
+{
+    FString Result;
+    FUtf8Codec::DecodeToString(Buffer.GetData() + Position, ByteLength, Result);
+    Position += ByteLength;
+    return Result;
+}
+
+bool UByteBuffer::TryGetInt32(int32& OutValue)
+{
+    return TryGet(OutValue);
+}
+
+bool UByteBuffer::TryGetUInt32(uint32& OutValue)
+{
+    return TryGet(OutValue);
+}
+
+bool UByteBuffer::TryGetByte(uint8& OutValue)
+{
+    return TryGet(OutValue);
+}
+
+bool UByteBuffer::TryGetFloat(float& OutValue)
+{
+    return TryGet(OutValue);
+}
+
+bool UByteBuffer::TryGetBool(bool& OutValue)
+{
+    return TryGet(OutValue);
+}
+
+bool UByteBuffer::TryGetVector(FVector& OutValue)
+{
+    if (Remaining() < 12)
+        return false;
+
+    OutValue.X = ReadUnchecked<float>();
+    OutValue.Y = ReadUnchecked<float>();
+    OutValue.Z = ReadUnchecked<float>();
+    return true;
+}
+
+bool UByteBuffer::TryGetRotator(FRotator& OutValue)
+{
+    if (Remaining() < 12)
+        return false;
+
+    OutValue.Pitch = ReadUnchecked<float>();
+    OutValue.Yaw = ReadUnchecked<float>();
+    OutValue.Roll = ReadUnchecked<float>();
+    return true;
+}
+
+bool UByteBuffer::TryGetString(FString& OutValue)
+{
+    const int32 Start = Position;
+    int32 Length = 0;
+
+    if (!TryGetInt32(Length) || Length < 0 || Remaining() < Length)
+    {
+        Position = Start;
+        return false;
+    }
+
+    OutValue = Length > 0 ? ReadStringUnchecked(Length) : FString();
+    return true;
+}
+
+FPacketSchema UByteBuffer::CompilePacketSchema(const TMap<FString, FString>& DataSequence)
+{
+    return FPacketSchema::Compile(DataSequence);
+}
+
+bool UByteBuffer::TryReadWithSchema(const FPacketSchema& Schema, TMap<FString, FDynamicValue>& OutValues)
+{
+    const int32 Start = Position;
+
+    if (Remaining() < Schema.MinSize)
+        return false;
+
+    const int32 NumFields = Schema.Fields.Num();
+    OutValues.Reserve(NumFields);
+
+    for (int32 i = 0; i < NumFields; ++i)
     {
+        const FPacketSchemaField& Field = Schema.Fields[i];
         FDynamicValue NewValue;
+        NewValue.ValueType = Field.ValueType;
 
-        if (Elem.Value == FString("id"))
-        {
-            NewValue.ValueType = EDynamicValueType::ID;
-            NewValue.StringValue = GetId();
-        }
-        else if (Elem.Value == FString("int32") || Elem.Value == FString("int"))
-        {
-            NewValue.ValueType = EDynamicValueType::Int32;
-            NewValue.IntValue = GetInt32();
-        }
-        else if (Elem.Value == FString("uint32") || Elem.Value == FString("uint"))
-        {
-            NewValue.ValueType = EDynamicValueType::UInt32;
-            NewValue.IntValue = GetUInt32();
-        }
-        else if (Elem.Value == FString("float"))
-        {
-            NewValue.ValueType = EDynamicValueType::Float;
-            NewValue.FloatValue = GetFloat();
-        }
-        else if (Elem.Value == FString("string") || Elem.Value == FString("str"))
+        switch (Field.ValueType)
         {
-            NewValue.ValueType = EDynamicValueType::String;
-            NewValue.StringValue = GetString();
-        }
-        else if (Elem.Value == FString("byte"))
+        case EDynamicValueType::ID:
+            NewValue.IntValue = ReadUnchecked<int32>();
+            break;
+        case EDynamicValueType::Int32:
+            NewValue.IntValue = ReadUnchecked<int32>();
+            break;
+        case EDynamicValueType::UInt32:
+            NewValue.UIntValue = ReadUnchecked<uint32>();
+            NewValue.IntValue = static_cast<int32>(NewValue.UIntValue);
+            break;
+        case EDynamicValueType::Float:
+            NewValue.FloatValue = ReadUnchecked<float>();
+            break;
+        case EDynamicValueType::Byte:
+            NewValue.ByteValue = ReadUnchecked<uint8>();
+            break;
+        case EDynamicValueType::Bool:
+            NewValue.BoolValue = ReadUnchecked<bool>();
+            break;
+        case EDynamicValueType::Int16:
+            NewValue.IntValue = ReadUnchecked<int16>();
+            break;
+        case EDynamicValueType::Int64:
+            NewValue.Int64Value = ReadUnchecked<int64>();
+            break;
+        case EDynamicValueType::Double:
+            NewValue.DoubleValue = ReadUnchecked<double>();
+            break;
+        case EDynamicValueType::Vector:
+            NewValue.VectorValue.X = ReadUnchecked<float>();
+            NewValue.VectorValue.Y = ReadUnchecked<float>();
+            NewValue.VectorValue.Z = ReadUnchecked<float>();
+            break;
+        case EDynamicValueType::Rotator:
+            NewValue.RotatorValue.Pitch = ReadUnchecked<float>();
+            NewValue.RotatorValue.Yaw = ReadUnchecked<float>();
+            NewValue.RotatorValue.Roll = ReadUnchecked<float>();
+            break;
+        case EDynamicValueType::String:
         {
-            NewValue.ValueType = EDynamicValueType::Byte;
-            NewValue.ByteValue = GetByte();
+            // Strings are the only variable-size field, so the bounds are re-validated once per string
+            // against everything that still has to follow it.
+            const int32 Length = ReadUnchecked<int32>();
+            const int32 TailMinSize = (i + 1 < NumFields) ? Schema.Fields[i + 1].RemainingMinSize : 0;
+
+            if (Length < 0 || Remaining() - TailMinSize < Length)
+            {
+                Position = Start;
+                return false;
+            }
+
+            if (Length > 0)
+                NewValue.StringValue = ReadStringUnchecked(Length);
+            break;
         }
-        else if (Elem.Value == FString("bool") || Elem.Value == FString("boolean"))
-        {
-            NewValue.ValueType = EDynamicValueType::Bool;
-            NewValue.BoolValue = GetBool();
+        default:
+            break;
         }
-        else if (Elem.Value == FString("vector"))
+
+        OutValues.Add(Field.Key, MoveTemp(NewValue));
+    }
+
+    return true;
+}
+
+bool UByteBuffer::ReadDataWithSchema(const FPacketSchema& Schema, UBufferData*& OutValues, uint8 PacketID)
+{
+    TMap<FString, FDynamicValue> Values;
+    Packet = PacketID;
+
+    if (!TryReadWithSchema(Schema, Values))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Malformed packet %d: Position=%d, BufferSize=%d, MinSize=%d"), Packet, Position, Buffer.Num(), Schema.MinSize);
+        OutValues = nullptr;
+        return false;
+    }
+
+    OutValues = NewObject<UBufferData>();
+    OutValues->Initialize(MoveTemp(Values));
+
+    return true;
+}
+
+bool UByteBuffer::ReadDataFromBuffer(const TMap<FString, FString>& DataSequence, UBufferData*& OutValues, uint8 PacketID)
+{
+    return ReadDataWithSchema(*FPacketSchema::FindOrCompile(DataSequence), OutValues, PacketID);
+}
+
+bool UByteBuffer::ReadDataLazy(const TSharedRef<const FPacketSchema>& Schema, UBufferData*& OutValues, uint8 PacketID)
+{
+    Packet = PacketID;
+    OutValues = nullptr;
+
+    const int32 NumFields = Schema->Fields.Num();
+    const uint8* Record = Buffer.GetData() + Position;
+    TArray<int32> FieldOffsets;
+    FieldOffsets.SetNumUninitialized(NumFields);
+
+    int32 RecordSize = INDEX_NONE;
+
+    if (Remaining() >= Schema->MinSize)
+    {
+        if (Schema->bFixedSize)
         {
-            NewValue.ValueType = EDynamicValueType::Vector;
-            NewValue.VectorValue = GetVector();
+            for (int32 i = 0; i < NumFields; ++i)
+                FieldOffsets[i] = Schema->Fields[i].Offset;
+
+            RecordSize = Schema->MinSize;
         }
-        else if (Elem.Value == FString("rotator"))
+        else
         {
-            NewValue.ValueType = EDynamicValueType::Rotator;
-            NewValue.RotatorValue = GetRotator();
+            RecordSize = Schema->FindFieldOffsets(Record, Remaining(), FieldOffsets.GetData());
         }
+    }
 
-        Values.Add(Elem.Key, NewValue);
+    if (RecordSize == INDEX_NONE)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Malformed packet %d: Position=%d, BufferSize=%d, MinSize=%d"), Packet, Position, Buffer.Num(), Schema->MinSize);
+        return false;
     }
 
     OutValues = NewObject<UBufferData>();
-    OutValues->Initialize(Values);
+    OutValues->InitializeLazy(Schema, TArrayView<const uint8>(Record, RecordSize), MoveTemp(FieldOffsets));
+    Position += RecordSize;
 
     return true;
 }
 
+bool UByteBuffer::ReadDataFromBufferLazy(const TMap<FString, FString>& DataSequence, UBufferData*& OutValues, uint8 PacketID)
+{
+    return ReadDataLazy(FPacketSchema::FindOrCompile(DataSequence), OutValues, PacketID);
+}
+
 void UByteBuffer::WriteDataToBuffer(const TMap<FString, FString>& DataSequence, const TArray<FDynamicValue>& Values)
 {
-    int32 ValueIndex = 0; 
+    WriteDataWithSchema(*FPacketSchema::FindOrCompile(DataSequence), Values);
+}
 
-    for (const TPair<FString, FString>& Elem : DataSequence)
+void UByteBuffer::WriteDataWithSchema(const FPacketSchema& Schema, TArrayView<const FDynamicValue> Values)
+{
+    const int32 NumFields = FMath::Min(Schema.Fields.Num(), Values.Num());
+
+    for (int32 i = 0; i < NumFields; ++i)
     {
-        if (ValueIndex >= Values.Num())        
-            break;
-        
-        const FDynamicValue& CurrentValue = Values[ValueIndex++];
+        const FDynamicValue& CurrentValue = Values[i];
 
-        if (Elem.Value.Equals("id"))
-            PutId(CurrentValue.StringValue);
-        else if (Elem.Value.Equals("int32") || Elem.Value.Equals("int"))
+        switch (Schema.Fields[i].ValueType)
+        {
+        case EDynamicValueType::ID:
+            if (CurrentValue.StringValue.IsEmpty())
+                PutNetId(FNetId(CurrentValue.IntValue));
+            else
+                PutId(CurrentValue.StringValue);
+            break;
+        case EDynamicValueType::Int32:
             PutInt32(CurrentValue.IntValue);
-        else if (Elem.Value.Equals("uint32") || Elem.Value.Equals("uint"))
+            break;
+        case EDynamicValueType::UInt32:
             PutInt32(CurrentValue.UIntValue);
-        else if (Elem.Value.Equals("float"))
+            break;
+        case EDynamicValueType::Float:
             PutFloat(CurrentValue.FloatValue);
-        else if (Elem.Value.Equals("string") || Elem.Value.Equals("str"))
+            break;
+        case EDynamicValueType::String:
             PutString(CurrentValue.StringValue);
-        else if (Elem.Value.Equals("byte"))
+            break;
+        case EDynamicValueType::Byte:
             PutByte(CurrentValue.ByteValue);
-        else if (Elem.Value.Equals("bool") || Elem.Value.Equals("boolean"))
+            break;
+        case EDynamicValueType::Bool:
             PutBool(CurrentValue.BoolValue);
-        else if (Elem.Value.Equals("vector"))
+            break;
+        case EDynamicValueType::Vector:
             PutVector(CurrentValue.VectorValue);
-        else if (Elem.Value.Equals("rotator"))
+            break;
+        case EDynamicValueType::Rotator:
             PutRotator(CurrentValue.RotatorValue);
+            break;
+        case EDynamicValueType::Int16:
+            PutInt16(CurrentValue.IntValue);
+            break;
+        case EDynamicValueType::Int64:
+            PutInt64(CurrentValue.Int64Value);
+            break;
+        case EDynamicValueType::Double:
+            PutDouble(CurrentValue.DoubleValue);
+            break;
+        default:
+            break;
+        }
     }
 }
 
 FString UByteBuffer::ToString() const
 {
-    return FBase64::Encode(Buffer);
+    return FBase64Codec::Encode(Buffer);
 }
 
 TArray<uint8>& UByteBuffer::GetBuffer() {
@@ -465,52 +1302,55 @@ int32 UByteBuffer::Length() {
 
 void UByteBuffer::AppendBuffer(UByteBuffer* OtherBuffer)
 {
-    Buffer.Reserve(Buffer.Num() + OtherBuffer->Buffer.Num());
-    Buffer.Append(OtherBuffer->Buffer);
+    if (OtherBuffer->InternSites.Num() > 0 && (InternSites.Num() == 0 || InternTable == OtherBuffer->InternTable))
+    {
+        InternTable = OtherBuffer->InternTable;
+
+        for (const FInternSite& Site : OtherBuffer->InternSites)
+        {
+            FInternSite& Moved = InternSites.Add_GetRef(Site);
+            Moved.Offset += Buffer.Num();
+        }
+    }
+
+    PutBytes(OtherBuffer->Buffer);
     Position = Buffer.Num();
 }
 
 TArray<UByteBuffer*> UByteBuffer::SplitPackets(UByteBuffer* CombinedBuffer) {
     TArray<UByteBuffer*> Packets;
-    const TArray<uint8>& BufferData = CombinedBuffer->GetBuffer();
-    int32 StartPosition = 1; 
-    int32 BufferSize = BufferData.Num();
 
-    for (int32 i = 1; i <= BufferSize - 4; ++i) {
-        if (
-            BufferData[i] == 0xFE && 
-            BufferData[i + 1] == 0xFE && 
-            BufferData[i + 2] == 0xFE && 
-            BufferData[i + 3] == 0xFE
-        ) {
-            if (i > StartPosition) {
-                TArray<uint8> PacketData;
-                PacketData.Append(&BufferData[StartPosition], i - StartPosition);
-                UByteBuffer* PacketBuffer = UByteBuffer::CreateByteBuffer(PacketData);
-                Packets.Add(PacketBuffer);
-            }
+    ForEachCombinedPacket(CombinedBuffer->GetBuffer(), [&Packets](const uint8* Data, int32 Size) {
+        Packets.Add(UByteBuffer::CreateByteBufferFromBytes(Data, Size));
+    });
 
-            StartPosition = i + 4;
-            i += 3;
-        }
-    }
+    return Packets;
+}
 
-    if (StartPosition < BufferSize) {
-        TArray<uint8> PacketData;
-        PacketData.Append(&BufferData[StartPosition], BufferSize - StartPosition);
-        UByteBuffer* PacketBuffer = UByteBuffer::CreateByteBuffer(PacketData);
-        Packets.Add(PacketBuffer);
-    }
+TArrayView<TArrayView<const uint8>> UByteBuffer::SplitPacketViews(UByteBuffer* CombinedBuffer, FFrameArena& Arena)
+{
+    int32 NumPackets = 0;
+    ForEachCombinedPacket(CombinedBuffer->GetBuffer(), [&NumPackets](const uint8*, int32) { ++NumPackets; });
 
-    return Packets;
+    TArrayView<TArrayView<const uint8>> Views = Arena.AllocateArray<TArrayView<const uint8>>(NumPackets);
+    int32 Index = 0;
+
+    ForEachCombinedPacket(CombinedBuffer->GetBuffer(), [&Views, &Index](const uint8* Data, int32 Size) {
+        Views[Index++] = TArrayView<const uint8>(Data, Size);
+    });
+
+    return Views;
+}
+
+bool UByteBuffer::TryReadRecord(const FPacketSchema& Schema, FFrameArena& Arena, FArenaRecord& OutRecord)
+{
+    return FArenaRecord::TryDecode(Schema, Buffer, Position, Arena, OutRecord);
 }
 
 FString UByteBuffer::ByteArrayToHexString(const TArray<uint8>& ByteArray)
 {
     FString HexString;
-
-    for (uint8 Byte : ByteArray)
-        HexString += FString::Printf(TEXT("%02x"), Byte);
+    FPacketLog::AppendHex(HexString, ByteArray);
 
     return HexString;
 }
@@ -518,15 +1358,7 @@ FString UByteBuffer::ByteArrayToHexString(const TArray<uint8>& ByteArray)
 FString UByteBuffer::ByteArrayToBinaryString(const TArray<uint8>& ByteArray)
 {
     FString IntString;
-
-    for (int32 i = 0; i < ByteArray.Num(); ++i)
-    {
-        IntString += FString::Printf(TEXT("%d"), ByteArray[i]);
-        if (i < ByteArray.Num() - 1)
-        {
-            IntString += TEXT(", ");
-        }
-    }
+    FPacketLog::AppendDecimalList(IntString, ByteArray);
 
     return IntString;
 }
\ No newline at end of file
@@ -3,8 +3,76 @@
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "Misc/Base64.h"
+#include "Misc/ByteSwap.h"
+#include <type_traits>
 #include "ByteBuffer.generated.h"
 
+class FNetStringTable;
+class FFrameArena;
+class FArenaRecord;
+class UWebSocket;
+
+namespace ByteBufferDetail
+{
+	template <SIZE_T Size> struct TUnsignedOfSize;
+	template <> struct TUnsignedOfSize<1> { using Type = uint8; };
+	template <> struct TUnsignedOfSize<2> { using Type = uint16; };
+	template <> struct TUnsignedOfSize<4> { using Type = uint32; };
+	template <> struct TUnsignedOfSize<8> { using Type = uint64; };
+
+	FORCEINLINE uint8 SwapBytes(uint8 Value) { return Value; }
+	FORCEINLINE uint16 SwapBytes(uint16 Value) { return BYTESWAP_ORDER16(Value); }
+	FORCEINLINE uint32 SwapBytes(uint32 Value) { return BYTESWAP_ORDER32(Value); }
+	FORCEINLINE uint64 SwapBytes(uint64 Value) { return BYTESWAP_ORDER64(Value); }
+
+	// The wire format is little endian; on little-endian hosts these compile to a single unaligned move.
+	template <typename T>
+	FORCEINLINE void Store(uint8* Out, T Value)
+	{
+		static_assert(std::is_arithmetic<T>::value, "ByteBuffer primitives must be arithmetic types");
+
+		if constexpr (std::is_same<T, bool>::value)
+		{
+			*Out = Value ? 1 : 0;
+		}
+		else
+		{
+#if PLATFORM_LITTLE_ENDIAN
+			FMemory::Memcpy(Out, &Value, sizeof(T));
+#else
+			typename TUnsignedOfSize<sizeof(T)>::Type Bits;
+			FMemory::Memcpy(&Bits, &Value, sizeof(T));
+			Bits = SwapBytes(Bits);
+			FMemory::Memcpy(Out, &Bits, sizeof(T));
+#endif
+		}
+	}
+
+	template <typename T>
+	FORCEINLINE T Load(const uint8* In)
+	{
+		static_assert(std::is_arithmetic<T>::value, "ByteBuffer primitives must be arithmetic types");
+
+		if constexpr (std::is_same<T, bool>::value)
+		{
+			return *In != 0;
+		}
+		else
+		{
+			T Value;
+#if PLATFORM_LITTLE_ENDIAN
+			FMemory::Memcpy(&Value, In, sizeof(T));
+#else
+			typename TUnsignedOfSize<sizeof(T)>::Type Bits;
+			FMemory::Memcpy(&Bits, In, sizeof(T));
+			Bits = SwapBytes(Bits);
+			FMemory::Memcpy(&Value, &Bits, sizeof(T));
+#endif
+			return Value;
+		}
+	}
+}
+
 UENUM(BlueprintType)
 enum class EDynamicValueType : uint8
 {
@@ -17,7 +85,10 @@ enum class EDynamicValueType : uint8
 	Byte,
 	Vector,
 	Rotator,
-	None
+	None,
+	Int16,
+	Int64,
+	Double
 };
 
 USTRUCT(BlueprintType)
@@ -51,6 +122,85 @@ public:
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ByteBuffer")
 	FRotator RotatorValue;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ByteBuffer")
+	int64 Int64Value;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ByteBuffer")
+	double DoubleValue;
+};
+
+USTRUCT(BlueprintType)
+struct FNetId
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ByteBuffer")
+	int32 Value = 0;
+
+	FNetId() = default;
+	explicit FNetId(int32 InValue) : Value(InValue) {}
+
+	bool operator==(const FNetId& Other) const { return Value == Other.Value; }
+	bool operator!=(const FNetId& Other) const { return Value != Other.Value; }
+
+	friend uint32 GetTypeHash(const FNetId& Id) { return ::GetTypeHash(Id.Value); }
+
+	FString ToString() const;
+
+	static FNetId FromString(const FString& Id);
+};
+
+USTRUCT(BlueprintType)
+struct FPacketSchemaField
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "ByteBuffer")
+	FString Key;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "ByteBuffer")
+	EDynamicValueType ValueType = EDynamicValueType::None;
+
+	// Byte offset from the start of the packet, INDEX_NONE once a variable-size field precedes it.
+	int32 Offset = INDEX_NONE;
+
+	// Minimum number of bytes needed to read this field and every field after it.
+	int32 RemainingMinSize = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FPacketSchema
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "ByteBuffer")
+	TArray<FPacketSchemaField> Fields;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "ByteBuffer")
+	int32 MinSize = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "ByteBuffer")
+	bool bFixedSize = true;
+
+	static FPacketSchema Compile(const TMap<FString, FString>& DataSequence);
+
+	// Compiled schemas are cached by field sequence, so repeated reads and writes skip the parse.
+	static TSharedRef<const FPacketSchema> FindOrCompile(const TMap<FString, FString>& DataSequence);
+	static EDynamicValueType ParseValueType(const FString& TypeName);
+	static int32 GetFixedSize(EDynamicValueType ValueType);
+
+	// Derives Offset, RemainingMinSize, MinSize and bFixedSize from the field types.
+	void ComputeLayout();
+
+	int32 FindField(const FString& Key) const;
+
+	// Fills OutOffsets (one per field) for a record of at least MinSize bytes and returns the record size,
+	// or INDEX_NONE if a string length does not fit.
+	int32 FindFieldOffsets(const uint8* Record, int32 Size, int32* OutOffsets) const;
 };
 
 UCLASS(BlueprintType)
@@ -60,10 +210,22 @@ class CLIENT_API UBufferData : public UObject
 
 public:
 	void Initialize(const TMap<FString, FDynamicValue>& InputData);
+	void Initialize(TMap<FString, FDynamicValue>&& InputData);
+
+	// Keeps a copy of the record bytes and decodes each field only when its getter is called.
+	void InitializeLazy(const TSharedRef<const FPacketSchema>& InSchema, TArrayView<const uint8> Record, TArray<int32>&& FieldOffsets);
+
+	bool IsLazy() const { return LazySchema.IsValid(); }
 
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	FString GetId(FString Key) const;
 
+	// Converts the id to Base36 on first access and keeps the string, so later lookups do not allocate.
+	const FString& GetIdRef(const FString& Key) const;
+
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	FNetId GetNetId(const FString& Key) const;
+
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	FString GetString(FString Key) const;
 
@@ -75,9 +237,15 @@ public:
 
 	uint32 GetUInt32(const FString& Key) const;
 
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	int64 GetInt64(const FString& Key) const;
+
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	float GetFloat(const FString& Key) const;
 
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	double GetDouble(const FString& Key) const;
+
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	uint8 GetByte(const FString& Key) const;
 
@@ -88,7 +256,14 @@ public:
 	FRotator GetRotator(const FString& Key) const;
 
 private:
-	TMap<FString, FDynamicValue> Data;
+	const uint8* FindLazyField(const FString& Key, EDynamicValueType& OutValueType) const;
+
+	// Mutable so id getters can keep the converted string alongside the decoded integer.
+	mutable TMap<FString, FDynamicValue> Data;
+
+	TSharedPtr<const FPacketSchema> LazySchema;
+	TArray<uint8> LazyBytes;
+	TArray<int32> LazyOffsets;
 };
 
 UCLASS(BlueprintType)
@@ -106,6 +281,9 @@ public:
 	UFUNCTION(BlueprintPure, Category = "ByteBuffer")
 	static UByteBuffer* CreateByteBufferFromString(const FString& Base64Data);
 
+	static UByteBuffer* CreateByteBufferWithCapacity(int32 Capacity);
+	static UByteBuffer* CreateByteBufferFromBytes(const uint8* Data, int32 Size);
+
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	static FString ByteArrayToHexString(const TArray<uint8>& ByteArray);
 
@@ -118,6 +296,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	FString GetId();
 
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	UByteBuffer* PutNetId(FNetId Id);
+
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	FNetId GetNetId();
+
+	UFUNCTION(BlueprintPure, Category = "ByteBuffer")
+	static FString NetIdToString(FNetId Id);
+
+	UFUNCTION(BlueprintPure, Category = "ByteBuffer")
+	static FNetId StringToNetId(const FString& Id);
+
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	UByteBuffer* PutInt32(int32 Value);
 
@@ -128,6 +318,56 @@ public:
 
 	uint32 GetUInt32();
 
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	UByteBuffer* PutInt16(int32 Value);
+
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	int32 GetInt16();
+
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	UByteBuffer* PutInt64(int64 Value);
+
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	int64 GetInt64();
+
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	UByteBuffer* PutDouble(double Value);
+
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	double GetDouble();
+
+	template <typename T>
+	UByteBuffer* Put(T Value)
+	{
+		ByteBufferDetail::Store(BeginWrite(sizeof(T)).GetData(), Value);
+		CommitWrite(sizeof(T));
+		return this;
+	}
+
+	template <typename T>
+	bool TryGet(T& OutValue)
+	{
+		TArrayView<const uint8> In = BeginRead(sizeof(T));
+
+		if (In.Num() == 0)
+			return false;
+
+		OutValue = ByteBufferDetail::Load<T>(In.GetData());
+		CommitRead(sizeof(T));
+		return true;
+	}
+
+	template <typename T>
+	T Get()
+	{
+		T Value = T();
+
+		if (!TryGet(Value))
+			LogReadOverflow();
+
+		return Value;
+	}
+
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	UByteBuffer* PutByte(uint8 Value);
 
@@ -140,6 +380,22 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	FString GetString();
 
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	UByteBuffer* PutInternedString(const FString& Value, UWebSocket* Connection);
+
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	FString GetInternedString(UWebSocket* Connection);
+
+	// Interned strings are written as uncached literals and only resolved against Table when the buffer is
+	// committed, which UWebSocket does as it sends. A buffer should be sent once; copying its bytes elsewhere
+	// (other than through AppendBuffer) sends the strings uncached.
+	UByteBuffer* WriteInternedString(const FString& Value, const TSharedPtr<FNetStringTable>& Table);
+	bool TryReadInternedString(FNetStringTable& Table, FString& OutValue);
+	void CommitInternedStrings(const TSharedPtr<FNetStringTable>& Table);
+
+	UByteBuffer* PutVarUInt32(uint32 Value);
+	bool TryGetVarUInt32(uint32& OutValue);
+
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	UByteBuffer* PutFloat(float Value);
 
@@ -164,12 +420,37 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	FRotator GetRotator();
 
+	bool TryGetInt32(int32& OutValue);
+	bool TryGetUInt32(uint32& OutValue);
+	bool TryGetByte(uint8& OutValue);
+	bool TryGetFloat(float& OutValue);
+	bool TryGetBool(bool& OutValue);
+	bool TryGetVector(FVector& OutValue);
+	bool TryGetRotator(FRotator& OutValue);
+	bool TryGetString(FString& OutValue);
+
+	UFUNCTION(BlueprintPure, Category = "ByteBuffer")
+	static FPacketSchema CompilePacketSchema(const TMap<FString, FString>& DataSequence);
+
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	bool ReadDataWithSchema(const FPacketSchema& Schema, UBufferData*& OutValues, uint8 PacketID);
+
+	bool TryReadWithSchema(const FPacketSchema& Schema, TMap<FString, FDynamicValue>& OutValues);
+
+	// Records field offsets only; values are decoded by the UBufferData getters on access.
+	bool ReadDataLazy(const TSharedRef<const FPacketSchema>& Schema, UBufferData*& OutValues, uint8 PacketID);
+
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	bool ReadDataFromBufferLazy(const TMap<FString, FString>& DataSequence, UBufferData*& OutValues, uint8 PacketID);
+
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	bool ReadDataFromBuffer(const TMap<FString, FString>& DataSequence, UBufferData*& OutValues, uint8 PacketID);
 
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	void WriteDataToBuffer(const TMap<FString, FString>& DataSequence, const TArray<FDynamicValue>& Values);
 
+	void WriteDataWithSchema(const FPacketSchema& Schema, TArrayView<const FDynamicValue> Values);
+
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	FString ToString() const;
 
@@ -179,16 +460,62 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	int32 Length();
 
+	UFUNCTION(BlueprintPure, Category = "ByteBuffer")
+	int32 Remaining() const;
+
+	// Returns MaxBytes of writable storage at the end of the buffer; CommitWrite appends the part that was filled.
+	TArrayView<uint8> BeginWrite(int32 MaxBytes);
+	void CommitWrite(int32 BytesWritten);
+
+	// Returns the next Bytes unread bytes, or an empty view if fewer remain; CommitRead consumes them.
+	TArrayView<const uint8> BeginRead(int32 Bytes) const;
+	void CommitRead(int32 BytesRead);
+
+	UByteBuffer* PutBytes(TArrayView<const uint8> Bytes);
+
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	void AppendBuffer(UByteBuffer* OtherBuffer);
 
 	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
 	TArray<UByteBuffer*> SplitPackets(UByteBuffer* CombinedBuffer);
 
+	// Views into CombinedBuffer's storage, valid while it is alive and unmodified and until the arena is reset.
+	static TArrayView<TArrayView<const uint8>> SplitPacketViews(UByteBuffer* CombinedBuffer, FFrameArena& Arena);
+
+	// Decodes into arena memory instead of a UBufferData; no UObject, map or FString is created.
+	bool TryReadRecord(const FPacketSchema& Schema, FFrameArena& Arena, FArenaRecord& OutRecord);
+
+	// Hands the storage back to FByteBufferPool early; the buffer is empty afterwards.
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	void ReleaseStorage();
+
+	virtual void BeginDestroy() override;
+
 private:
+	struct FInternSite
+	{
+		int32 Offset = 0;
+		int32 Size = 0;
+		FString Value;
+	};
+
 	TArray<uint8> Buffer;
 	int32 Position = 0;
 	uint8 Packet = 0;
 
+	TSharedPtr<FNetStringTable> InternTable;
+	TArray<FInternSite> InternSites;
+
 	void EnsureCapacity(int32 RequiredBytes);
+
+	template <typename T>
+	T ReadUnchecked()
+	{
+		T Value = ByteBufferDetail::Load<T>(Buffer.GetData() + Position);
+		Position += sizeof(T);
+		return Value;
+	}
+
+	FString ReadStringUnchecked(int32 ByteLength);
+	void LogReadOverflow() const;
 };
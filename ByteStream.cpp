@@ -0,0 +1,115 @@
+#include "ByteStream.h"
+#include "ByteBuffer.h"
+#include "Websocket.h"
+#include "QueueBuffer.h"
+
+void FByteStreamHeader::Write(uint8* Out) const
+{
+	ByteBufferDetail::Store<uint32>(Out, StreamId);
+	ByteBufferDetail::Store<uint32>(Out + 4, Sequence);
+	Out[8] = Flags;
+}
+
+bool FByteStreamHeader::Parse(const uint8* Data, int32 DataSize, FByteStreamHeader& OutHeader)
+{
+	if (DataSize < Size)
+		return false;
+
+	OutHeader.StreamId = ByteBufferDetail::Load<uint32>(Data);
+	OutHeader.Sequence = ByteBufferDetail::Load<uint32>(Data + 4);
+	OutHeader.Flags = Data[8];
+	return true;
+}
+
+void UByteStreamWriter::Initialize(UWebSocket* InSocket, const FString& InKey, uint8 InPacketType, uint32 InStreamId, int32 InChunkSize)
+{
+	Socket = InSocket;
+	Key = InKey;
+	PacketType = InPacketType;
+	StreamId = InStreamId;
+	ChunkSize = FMath::Max(InChunkSize, 1);
+}
+
+void UByteStreamWriter::Write(UByteBuffer* Data)
+{
+	if (Data)
+		WriteBytes(Data->GetBuffer());
+}
+
+void UByteStreamWriter::WriteBytes(TArrayView<const uint8> Bytes)
+{
+	if (bClosed)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Attempted to write to closed stream %u"), StreamId);
+		return;
+	}
+
+	BytesWritten += Bytes.Num();
+
+	while (Bytes.Num() > 0)
+	{
+		if (ChunkPayload == 0)
+			BeginChunk();
+
+		const int32 Count = FMath::Min(ChunkSize - ChunkPayload, Bytes.Num());
+		Chunk->PutBytes(Bytes.Left(Count));
+		ChunkPayload += Count;
+		Bytes = Bytes.RightChop(Count);
+
+		if (ChunkPayload == ChunkSize)
+			SendChunk(false);
+	}
+}
+
+void UByteStreamWriter::Close()
+{
+	if (bClosed)
+		return;
+
+	if (ChunkPayload == 0)
+		BeginChunk();
+
+	SendChunk(true);
+	bClosed = true;
+	Chunk = nullptr;
+}
+
+void UByteStreamWriter::BeginChunk()
+{
+	if (!Chunk)
+		Chunk = UByteBuffer::CreateByteBufferWithCapacity(FByteStreamHeader::Size + ChunkSize);
+
+	FByteStreamHeader Header;
+	Header.StreamId = StreamId;
+	Header.Sequence = NextSequence++;
+
+	Header.Write(Chunk->BeginWrite(FByteStreamHeader::Size + ChunkSize).GetData());
+	Chunk->CommitWrite(FByteStreamHeader::Size);
+}
+
+void UByteStreamWriter::SendChunk(bool bLast)
+{
+	if (bLast)
+		Chunk->GetBuffer()[8] |= FByteStreamHeader::LastChunkFlag;
+
+	if (Queue)
+	{
+		// The queue holds on to the chunk until it is sent, so the next one needs a buffer of its own.
+		Queue->AddStandaloneBuffer(PacketType, Chunk);
+		Chunk = nullptr;
+		ChunkPayload = 0;
+		return;
+	}
+
+	if (Socket)
+	{
+		if (Key.IsEmpty())
+			Socket->SendMessage(PacketType, Chunk);
+		else
+			Socket->SendEncryptedMessage(PacketType, Chunk, Key);
+	}
+
+	Chunk->ReleaseStorage();
+
+	ChunkPayload = 0;
+}
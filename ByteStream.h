@@ -0,0 +1,84 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "ByteStream.generated.h"
+
+class UWebSocket;
+class UByteBuffer;
+class UQueueBuffer;
+
+// Every stream chunk is sent as its own packet: stream packet type, this header, then up to ChunkSize payload bytes.
+struct FByteStreamHeader
+{
+	static constexpr int32 Size = 9;
+	static constexpr uint8 LastChunkFlag = 1;
+
+	uint32 StreamId = 0;
+	uint32 Sequence = 0;
+	uint8 Flags = 0;
+
+	void Write(uint8* Out) const;
+	static bool Parse(const uint8* Data, int32 DataSize, FByteStreamHeader& OutHeader);
+};
+
+struct FByteStreamAssembly
+{
+	TArray<uint8> Data;
+	uint32 NextSequence = 0;
+	int64 LastActivityMicros = 0;
+};
+
+// Sends a large payload as a sequence of chunks while it is being produced, holding at most one chunk.
+// Each chunk goes out as its own frame as soon as it fills, encrypted with Key when one is set. With a queue
+// set, filled chunks are instead queued on it as standalone buffers, never combined, since combined frames
+// are split on a delimiter that chunk payloads may contain.
+UCLASS(MinimalAPI, BlueprintType)
+class UByteStreamWriter final : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(UWebSocket* InSocket, const FString& InKey, uint8 InPacketType, uint32 InStreamId, int32 InChunkSize);
+	void SetQueue(UQueueBuffer* InQueue) { Queue = InQueue; }
+
+	UFUNCTION(BlueprintCallable, Category = "ByteStream")
+	void Write(UByteBuffer* Data);
+
+	void WriteBytes(TArrayView<const uint8> Bytes);
+
+	// Sends whatever is buffered as the last chunk; an empty last chunk is sent if nothing is pending.
+	UFUNCTION(BlueprintCallable, Category = "ByteStream")
+	void Close();
+
+	UFUNCTION(BlueprintPure, Category = "ByteStream")
+	int32 GetStreamId() const { return static_cast<int32>(StreamId); }
+
+	UFUNCTION(BlueprintPure, Category = "ByteStream")
+	bool IsClosed() const { return bClosed; }
+
+	UFUNCTION(BlueprintPure, Category = "ByteStream")
+	int64 GetBytesWritten() const { return BytesWritten; }
+
+private:
+	void BeginChunk();
+	void SendChunk(bool bLast);
+
+	UPROPERTY()
+	UWebSocket* Socket = nullptr;
+
+	UPROPERTY()
+	UQueueBuffer* Queue = nullptr;
+
+	UPROPERTY()
+	UByteBuffer* Chunk = nullptr;
+
+	FString Key;
+	uint8 PacketType = 0;
+	uint32 StreamId = 0;
+	uint32 NextSequence = 0;
+	int32 ChunkSize = 0;
+	int32 ChunkPayload = 0;
+	int64 BytesWritten = 0;
+	bool bClosed = false;
+};
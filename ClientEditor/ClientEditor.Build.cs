@@ -0,0 +1,13 @@
+using UnrealBuildTool;
+
+// Blueprint nodes for the Client runtime module. Uncooked-only, so games never link the editor graph modules.
+public class ClientEditor : ModuleRules
+{
+	public ClientEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "BlueprintGraph", "Client" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "KismetCompiler", "UnrealEd" });
+	}
+}
@@ -0,0 +1,203 @@
+#include "K2Node_PacketBase.h"
+#include "PacketSchemaAsset.h"
+#include "K2Node_CallFunction.h"
+#include "KismetCompiler.h"
+#include "EdGraphSchema_K2.h"
+#include "BlueprintActionDatabaseRegistrar.h"
+#include "BlueprintNodeSpawner.h"
+
+#define LOCTEXT_NAMESPACE "K2Node_Packet"
+
+const FName UK2Node_PacketBase::BufferPinName(TEXT("Buffer"));
+
+void UK2Node_PacketBase::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(UK2Node_PacketBase, Schema))
+		ReconstructNode();
+}
+
+void UK2Node_PacketBase::PreloadRequiredAssets()
+{
+	PreloadObject(Schema);
+	Super::PreloadRequiredAssets();
+}
+
+void UK2Node_PacketBase::GetMenuActions(FBlueprintActionDatabaseRegistrar& ActionRegistrar) const
+{
+	UClass* ActionKey = GetClass();
+
+	if (ActionRegistrar.IsOpenForRegistration(ActionKey))
+	{
+		UBlueprintNodeSpawner* NodeSpawner = UBlueprintNodeSpawner::Create(ActionKey);
+		check(NodeSpawner != nullptr);
+		ActionRegistrar.AddBlueprintAction(ActionKey, NodeSpawner);
+	}
+}
+
+FText UK2Node_PacketBase::GetMenuCategory() const
+{
+	return LOCTEXT("MenuCategory", "ByteBuffer");
+}
+
+UEdGraphPin* UK2Node_PacketBase::GetBufferPin() const
+{
+	return FindPinChecked(BufferPinName, EGPD_Input);
+}
+
+void UK2Node_PacketBase::CreateFieldPins(EEdGraphPinDirection Direction)
+{
+	if (!Schema)
+		return;
+
+	for (const FPacketSchemaFieldDefinition& Field : Schema->Fields)
+	{
+		FEdGraphPinType PinType;
+		const FName PinName(*Field.Key);
+
+		if (Field.Key.IsEmpty() || FindPin(PinName) || !GetFieldPinType(Field.ValueType, PinType))
+			continue;
+
+		CreatePin(Direction, PinType, PinName);
+	}
+}
+
+bool UK2Node_PacketBase::ValidateForExpansion(FKismetCompilerContext& CompilerContext)
+{
+	if (!Schema)
+	{
+		CompilerContext.MessageLog.Error(*LOCTEXT("MissingSchema", "@@ has no packet schema").ToString(), this);
+		return false;
+	}
+
+	if (Schema->Fields.Num() == 0)
+	{
+		CompilerContext.MessageLog.Error(*LOCTEXT("EmptySchema", "@@ has an empty packet schema").ToString(), this);
+		return false;
+	}
+
+	if (GetBufferPin()->LinkedTo.Num() == 0)
+	{
+		CompilerContext.MessageLog.Error(*LOCTEXT("MissingBuffer", "@@ needs a buffer").ToString(), this);
+		return false;
+	}
+
+	for (const FPacketSchemaFieldDefinition& Field : Schema->Fields)
+	{
+		if (GetFieldFunctionName(Field.ValueType, false).IsNone())
+		{
+			CompilerContext.MessageLog.Error(*FText::Format(LOCTEXT("UnsupportedField", "@@: field '{0}' has no Blueprint type"), FText::FromString(Field.Key)).ToString(), this);
+			return false;
+		}
+
+		const UEdGraphPin* FieldPin = FindPin(FName(*Field.Key));
+
+		if (!FieldPin || FieldPin->PinName == BufferPinName || FieldPin->PinType.PinCategory == UEdGraphSchema_K2::PC_Exec)
+		{
+			CompilerContext.MessageLog.Error(*FText::Format(LOCTEXT("FieldPinMissing", "@@: field '{0}' has no pin of its own; rename it or refresh the node"), FText::FromString(Field.Key)).ToString(), this);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+UK2Node_CallFunction* UK2Node_PacketBase::SpawnBufferCall(FKismetCompilerContext& CompilerContext, UEdGraph* SourceGraph, FName FunctionName, UEdGraphPin*& InOutThen)
+{
+	UK2Node_CallFunction* CallNode = CompilerContext.SpawnIntermediateNode<UK2Node_CallFunction>(this, SourceGraph);
+	CallNode->FunctionReference.SetExternalMember(FunctionName, UByteBuffer::StaticClass());
+	CallNode->AllocateDefaultPins();
+
+	CompilerContext.CopyPinLinksToIntermediate(*GetBufferPin(), *CallNode->FindPinChecked(UEdGraphSchema_K2::PN_Self));
+
+	if (InOutThen)
+		InOutThen->MakeLinkTo(CallNode->GetExecPin());
+	else
+		CompilerContext.MovePinLinksToIntermediate(*GetExecPin(), *CallNode->GetExecPin());
+
+	InOutThen = CallNode->GetThenPin();
+
+	return CallNode;
+}
+
+bool UK2Node_PacketBase::GetFieldPinType(EDynamicValueType ValueType, FEdGraphPinType& OutPinType)
+{
+	switch (ValueType)
+	{
+	case EDynamicValueType::ID:
+		OutPinType.PinCategory = UEdGraphSchema_K2::PC_Struct;
+		OutPinType.PinSubCategoryObject = FNetId::StaticStruct();
+		return true;
+	case EDynamicValueType::Int32:
+	case EDynamicValueType::UInt32:
+	case EDynamicValueType::Int16:
+		OutPinType.PinCategory = UEdGraphSchema_K2::PC_Int;
+		return true;
+	case EDynamicValueType::Int64:
+		OutPinType.PinCategory = UEdGraphSchema_K2::PC_Int64;
+		return true;
+	case EDynamicValueType::Float:
+		OutPinType.PinCategory = UEdGraphSchema_K2::PC_Real;
+		OutPinType.PinSubCategory = UEdGraphSchema_K2::PC_Float;
+		return true;
+	case EDynamicValueType::Double:
+		OutPinType.PinCategory = UEdGraphSchema_K2::PC_Real;
+		OutPinType.PinSubCategory = UEdGraphSchema_K2::PC_Double;
+		return true;
+	case EDynamicValueType::Bool:
+		OutPinType.PinCategory = UEdGraphSchema_K2::PC_Boolean;
+		return true;
+	case EDynamicValueType::Byte:
+		OutPinType.PinCategory = UEdGraphSchema_K2::PC_Byte;
+		return true;
+	case EDynamicValueType::String:
+		OutPinType.PinCategory = UEdGraphSchema_K2::PC_String;
+		return true;
+	case EDynamicValueType::Vector:
+		OutPinType.PinCategory = UEdGraphSchema_K2::PC_Struct;
+		OutPinType.PinSubCategoryObject = TBaseStructure<FVector>::Get();
+		return true;
+	case EDynamicValueType::Rotator:
+		OutPinType.PinCategory = UEdGraphSchema_K2::PC_Struct;
+		OutPinType.PinSubCategoryObject = TBaseStructure<FRotator>::Get();
+		return true;
+	default:
+		return false;
+	}
+}
+
+FName UK2Node_PacketBase::GetFieldFunctionName(EDynamicValueType ValueType, bool bWrite)
+{
+	// UInt32 has no Blueprint type; it travels through the int32 calls, which move the same four bytes.
+	switch (ValueType)
+	{
+	case EDynamicValueType::ID:
+		return bWrite ? GET_FUNCTION_NAME_CHECKED(UByteBuffer, PutNetId) : GET_FUNCTION_NAME_CHECKED(UByteBuffer, GetNetId);
+	case EDynamicValueType::Int32:
+	case EDynamicValueType::UInt32:
+		return bWrite ? GET_FUNCTION_NAME_CHECKED(UByteBuffer, PutInt32) : GET_FUNCTION_NAME_CHECKED(UByteBuffer, GetInt32);
+	case EDynamicValueType::Int16:
+		return bWrite ? GET_FUNCTION_NAME_CHECKED(UByteBuffer, PutInt16) : GET_FUNCTION_NAME_CHECKED(UByteBuffer, GetInt16);
+	case EDynamicValueType::Int64:
+		return bWrite ? GET_FUNCTION_NAME_CHECKED(UByteBuffer, PutInt64) : GET_FUNCTION_NAME_CHECKED(UByteBuffer, GetInt64);
+	case EDynamicValueType::Float:
+		return bWrite ? GET_FUNCTION_NAME_CHECKED(UByteBuffer, PutFloat) : GET_FUNCTION_NAME_CHECKED(UByteBuffer, GetFloat);
+	case EDynamicValueType::Double:
+		return bWrite ? GET_FUNCTION_NAME_CHECKED(UByteBuffer, PutDouble) : GET_FUNCTION_NAME_CHECKED(UByteBuffer, GetDouble);
+	case EDynamicValueType::Bool:
+		return bWrite ? GET_FUNCTION_NAME_CHECKED(UByteBuffer, PutBool) : GET_FUNCTION_NAME_CHECKED(UByteBuffer, GetBool);
+	case EDynamicValueType::Byte:
+		return bWrite ? GET_FUNCTION_NAME_CHECKED(UByteBuffer, PutByte) : GET_FUNCTION_NAME_CHECKED(UByteBuffer, GetByte);
+	case EDynamicValueType::String:
+		return bWrite ? GET_FUNCTION_NAME_CHECKED(UByteBuffer, PutString) : GET_FUNCTION_NAME_CHECKED(UByteBuffer, GetString);
+	case EDynamicValueType::Vector:
+		return bWrite ? GET_FUNCTION_NAME_CHECKED(UByteBuffer, PutVector) : GET_FUNCTION_NAME_CHECKED(UByteBuffer, GetVector);
+	case EDynamicValueType::Rotator:
+		return bWrite ? GET_FUNCTION_NAME_CHECKED(UByteBuffer, PutRotator) : GET_FUNCTION_NAME_CHECKED(UByteBuffer, GetRotator);
+	default:
+		return NAME_None;
+	}
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "K2Node.h"
+#include "ByteBuffer.h"
+#include "K2Node_PacketBase.generated.h"
+
+class UK2Node_CallFunction;
+class UPacketSchemaAsset;
+class FKismetCompilerContext;
+
+// Editor-only base for the schema-driven packet nodes: one typed pin per schema field, expanded at compile
+// time into a chain of native UByteBuffer Get*/Put* calls.
+UCLASS(Abstract, MinimalAPI)
+class UK2Node_PacketBase : public UK2Node
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, Category = "ByteBuffer")
+	UPacketSchemaAsset* Schema;
+
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual void PreloadRequiredAssets() override;
+	virtual void GetMenuActions(FBlueprintActionDatabaseRegistrar& ActionRegistrar) const override;
+	virtual FText GetMenuCategory() const override;
+	virtual bool IsNodeSafeToIgnore() const override { return true; }
+
+protected:
+	static const FName BufferPinName;
+
+	UEdGraphPin* GetBufferPin() const;
+	void CreateFieldPins(EEdGraphPinDirection Direction);
+	bool ValidateForExpansion(FKismetCompilerContext& CompilerContext);
+
+	// Spawns a call to a UByteBuffer function on the node's buffer and chains it after InOutThen; a null
+	// InOutThen hands it the node's own incoming exec links instead.
+	UK2Node_CallFunction* SpawnBufferCall(FKismetCompilerContext& CompilerContext, UEdGraph* SourceGraph, FName FunctionName, UEdGraphPin*& InOutThen);
+
+	static bool GetFieldPinType(EDynamicValueType ValueType, FEdGraphPinType& OutPinType);
+	static FName GetFieldFunctionName(EDynamicValueType ValueType, bool bWrite);
+};
@@ -0,0 +1,76 @@
+#include "K2Node_ReadPacket.h"
+#include "PacketSchemaAsset.h"
+#include "K2Node_CallFunction.h"
+#include "K2Node_IfThenElse.h"
+#include "KismetCompiler.h"
+#include "EdGraphSchema_K2.h"
+
+#define LOCTEXT_NAMESPACE "K2Node_Packet"
+
+const FName UK2Node_ReadPacket::FailedPinName(TEXT("Failed"));
+
+void UK2Node_ReadPacket::AllocateDefaultPins()
+{
+	CreatePin(EGPD_Input, UEdGraphSchema_K2::PC_Exec, UEdGraphSchema_K2::PN_Execute);
+	CreatePin(EGPD_Output, UEdGraphSchema_K2::PC_Exec, UEdGraphSchema_K2::PN_Then);
+	CreatePin(EGPD_Output, UEdGraphSchema_K2::PC_Exec, FailedPinName);
+	CreatePin(EGPD_Input, UEdGraphSchema_K2::PC_Object, UByteBuffer::StaticClass(), BufferPinName);
+
+	CreateFieldPins(EGPD_Output);
+
+	Super::AllocateDefaultPins();
+}
+
+FText UK2Node_ReadPacket::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	if (Schema)
+		return FText::Format(LOCTEXT("ReadPacketTitle", "Read Packet ({0})"), FText::FromString(Schema->GetName()));
+
+	return LOCTEXT("ReadPacket", "Read Packet");
+}
+
+FText UK2Node_ReadPacket::GetTooltipText() const
+{
+	return LOCTEXT("ReadPacketTooltip", "Reads one record of the packet schema from the buffer into typed pins.");
+}
+
+void UK2Node_ReadPacket::ExpandNode(FKismetCompilerContext& CompilerContext, UEdGraph* SourceGraph)
+{
+	Super::ExpandNode(CompilerContext, SourceGraph);
+
+	if (!ValidateForExpansion(CompilerContext))
+	{
+		BreakAllNodeLinks();
+		return;
+	}
+
+	UK2Node_CallFunction* CanReadNode = CompilerContext.SpawnIntermediateNode<UK2Node_CallFunction>(this, SourceGraph);
+	CanReadNode->FunctionReference.SetExternalMember(GET_FUNCTION_NAME_CHECKED(UPacketSchemaAsset, CanRead), UPacketSchemaAsset::StaticClass());
+	CanReadNode->AllocateDefaultPins();
+	CanReadNode->FindPinChecked(UEdGraphSchema_K2::PN_Self)->DefaultObject = Schema;
+	CompilerContext.CopyPinLinksToIntermediate(*GetBufferPin(), *CanReadNode->FindPinChecked(TEXT("Buffer")));
+	CompilerContext.MovePinLinksToIntermediate(*GetExecPin(), *CanReadNode->GetExecPin());
+
+	UK2Node_IfThenElse* BranchNode = CompilerContext.SpawnIntermediateNode<UK2Node_IfThenElse>(this, SourceGraph);
+	BranchNode->AllocateDefaultPins();
+	CanReadNode->GetThenPin()->MakeLinkTo(BranchNode->GetExecPin());
+	CanReadNode->GetReturnValuePin()->MakeLinkTo(BranchNode->GetConditionPin());
+	CompilerContext.MovePinLinksToIntermediate(*FindPinChecked(FailedPinName), *BranchNode->GetElsePin());
+
+	// Every field is read, connected or not, so the buffer ends up past the whole record.
+	UEdGraphPin* LastThen = BranchNode->GetThenPin();
+
+	for (const FPacketSchemaFieldDefinition& Field : Schema->Fields)
+	{
+		UK2Node_CallFunction* ReadNode = SpawnBufferCall(CompilerContext, SourceGraph, GetFieldFunctionName(Field.ValueType, false), LastThen);
+
+		if (UEdGraphPin* FieldPin = FindPin(FName(*Field.Key), EGPD_Output))
+			CompilerContext.MovePinLinksToIntermediate(*FieldPin, *ReadNode->GetReturnValuePin());
+	}
+
+	CompilerContext.MovePinLinksToIntermediate(*GetThenPin(), *LastThen);
+
+	BreakAllNodeLinks();
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "K2Node_PacketBase.h"
+#include "K2Node_ReadPacket.generated.h"
+
+// Reads one record of the schema from the buffer's read position into typed output pins. Takes the Failed
+// exec path, without consuming anything, when the buffer does not hold a complete record.
+UCLASS(MinimalAPI)
+class UK2Node_ReadPacket : public UK2Node_PacketBase
+{
+	GENERATED_BODY()
+
+public:
+	virtual void AllocateDefaultPins() override;
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FText GetTooltipText() const override;
+	virtual void ExpandNode(FKismetCompilerContext& CompilerContext, UEdGraph* SourceGraph) override;
+
+private:
+	static const FName FailedPinName;
+};
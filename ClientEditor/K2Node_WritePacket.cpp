@@ -0,0 +1,70 @@
+#include "K2Node_WritePacket.h"
+#include "PacketSchemaAsset.h"
+#include "K2Node_CallFunction.h"
+#include "KismetCompiler.h"
+#include "EdGraphSchema_K2.h"
+
+#define LOCTEXT_NAMESPACE "K2Node_Packet"
+
+void UK2Node_WritePacket::AllocateDefaultPins()
+{
+	CreatePin(EGPD_Input, UEdGraphSchema_K2::PC_Exec, UEdGraphSchema_K2::PN_Execute);
+	CreatePin(EGPD_Output, UEdGraphSchema_K2::PC_Exec, UEdGraphSchema_K2::PN_Then);
+	CreatePin(EGPD_Input, UEdGraphSchema_K2::PC_Object, UByteBuffer::StaticClass(), BufferPinName);
+
+	CreateFieldPins(EGPD_Input);
+
+	Super::AllocateDefaultPins();
+}
+
+FText UK2Node_WritePacket::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	if (Schema)
+		return FText::Format(LOCTEXT("WritePacketTitle", "Write Packet ({0})"), FText::FromString(Schema->GetName()));
+
+	return LOCTEXT("WritePacket", "Write Packet");
+}
+
+FText UK2Node_WritePacket::GetTooltipText() const
+{
+	return LOCTEXT("WritePacketTooltip", "Appends one record of the packet schema to the buffer from typed pins.");
+}
+
+void UK2Node_WritePacket::ExpandNode(FKismetCompilerContext& CompilerContext, UEdGraph* SourceGraph)
+{
+	Super::ExpandNode(CompilerContext, SourceGraph);
+
+	if (!ValidateForExpansion(CompilerContext))
+	{
+		BreakAllNodeLinks();
+		return;
+	}
+
+	UEdGraphPin* LastThen = nullptr;
+
+	for (const FPacketSchemaFieldDefinition& Field : Schema->Fields)
+	{
+		UK2Node_CallFunction* WriteNode = SpawnBufferCall(CompilerContext, SourceGraph, GetFieldFunctionName(Field.ValueType, true), LastThen);
+		UEdGraphPin* ValuePin = nullptr;
+
+		for (UEdGraphPin* Pin : WriteNode->Pins)
+		{
+			if (Pin->Direction == EGPD_Input && Pin->PinType.PinCategory != UEdGraphSchema_K2::PC_Exec && Pin->PinName != UEdGraphSchema_K2::PN_Self)
+			{
+				ValuePin = Pin;
+				break;
+			}
+		}
+
+		UEdGraphPin* FieldPin = FindPin(FName(*Field.Key), EGPD_Input);
+
+		if (FieldPin && ValuePin)
+			CompilerContext.MovePinLinksToIntermediate(*FieldPin, *ValuePin);
+	}
+
+	CompilerContext.MovePinLinksToIntermediate(*GetThenPin(), *LastThen);
+
+	BreakAllNodeLinks();
+}
+
+#undef LOCTEXT_NAMESPACE
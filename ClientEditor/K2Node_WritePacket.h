@@ -0,0 +1,18 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "K2Node_PacketBase.h"
+#include "K2Node_WritePacket.generated.h"
+
+// Appends one record of the schema to the buffer from typed input pins.
+UCLASS(MinimalAPI)
+class UK2Node_WritePacket : public UK2Node_PacketBase
+{
+	GENERATED_BODY()
+
+public:
+	virtual void AllocateDefaultPins() override;
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FText GetTooltipText() const override;
+	virtual void ExpandNode(FKismetCompilerContext& CompilerContext, UEdGraph* SourceGraph) override;
+};
@@ -0,0 +1,201 @@
+#include "ColumnDecoder.h"
+#include "Utf8Codec.h"
+
+using ByteBufferDetail::Load;
+
+FPacketColumnDecoder::FPacketColumnDecoder(const FPacketSchema& InSchema)
+	: Schema(InSchema)
+{
+}
+
+bool FPacketColumnDecoder::Bind(const FString& Key, TArray<int32>& Column) { return BindColumn(Key, EColumnType::Int32, &Column); }
+bool FPacketColumnDecoder::Bind(const FString& Key, TArray<FNetId>& Column) { return BindColumn(Key, EColumnType::NetId, &Column); }
+bool FPacketColumnDecoder::Bind(const FString& Key, TArray<uint32>& Column) { return BindColumn(Key, EColumnType::UInt32, &Column); }
+bool FPacketColumnDecoder::Bind(const FString& Key, TArray<int64>& Column) { return BindColumn(Key, EColumnType::Int64, &Column); }
+bool FPacketColumnDecoder::Bind(const FString& Key, TArray<float>& Column) { return BindColumn(Key, EColumnType::Float, &Column); }
+bool FPacketColumnDecoder::Bind(const FString& Key, TArray<double>& Column) { return BindColumn(Key, EColumnType::Double, &Column); }
+bool FPacketColumnDecoder::Bind(const FString& Key, TArray<uint8>& Column) { return BindColumn(Key, EColumnType::Byte, &Column); }
+bool FPacketColumnDecoder::Bind(const FString& Key, TArray<bool>& Column) { return BindColumn(Key, EColumnType::Bool, &Column); }
+bool FPacketColumnDecoder::Bind(const FString& Key, TArray<FVector>& Column) { return BindColumn(Key, EColumnType::Vector, &Column); }
+bool FPacketColumnDecoder::Bind(const FString& Key, TArray<FRotator>& Column) { return BindColumn(Key, EColumnType::Rotator, &Column); }
+bool FPacketColumnDecoder::Bind(const FString& Key, TArray<FString>& Column) { return BindColumn(Key, EColumnType::String, &Column); }
+
+bool FPacketColumnDecoder::BindColumn(const FString& Key, EColumnType ColumnType, void* Array)
+{
+	const int32 FieldIndex = Schema.FindField(Key);
+
+	if (FieldIndex == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Column '%s' is not part of the schema"), *Key);
+		return false;
+	}
+
+	bool bCompatible = false;
+
+	switch (Schema.Fields[FieldIndex].ValueType)
+	{
+	case EDynamicValueType::ID:
+		bCompatible = ColumnType == EColumnType::NetId || ColumnType == EColumnType::Int32;
+		break;
+	case EDynamicValueType::Int32:
+	case EDynamicValueType::Int16:
+		bCompatible = ColumnType == EColumnType::Int32;
+		break;
+	case EDynamicValueType::UInt32:
+		bCompatible = ColumnType == EColumnType::UInt32;
+		break;
+	case EDynamicValueType::Int64:
+		bCompatible = ColumnType == EColumnType::Int64;
+		break;
+	case EDynamicValueType::Float:
+		bCompatible = ColumnType == EColumnType::Float;
+		break;
+	case EDynamicValueType::Double:
+		bCompatible = ColumnType == EColumnType::Double;
+		break;
+	case EDynamicValueType::Byte:
+		bCompatible = ColumnType == EColumnType::Byte;
+		break;
+	case EDynamicValueType::Bool:
+		bCompatible = ColumnType == EColumnType::Bool;
+		break;
+	case EDynamicValueType::Vector:
+		bCompatible = ColumnType == EColumnType::Vector;
+		break;
+	case EDynamicValueType::Rotator:
+		bCompatible = ColumnType == EColumnType::Rotator;
+		break;
+	case EDynamicValueType::String:
+		bCompatible = ColumnType == EColumnType::String;
+		break;
+	default:
+		break;
+	}
+
+	if (!bCompatible)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Column '%s' does not match the schema field type"), *Key);
+		return false;
+	}
+
+	FColumn& Column = Columns.AddDefaulted_GetRef();
+	Column.FieldIndex = FieldIndex;
+	Column.ColumnType = ColumnType;
+	Column.Array = Array;
+	return true;
+}
+
+template <typename T, typename ReadFuncType>
+void FPacketColumnDecoder::FillColumn(TArray<T>& Column, int32 FieldIndex, ReadFuncType Read) const
+{
+	const int32 NumRecords = Records.Num();
+	const uint8* const* RecordData = Records.GetData();
+
+	Column.SetNumUninitialized(NumRecords);
+	T* Out = Column.GetData();
+
+	if (Schema.bFixedSize)
+	{
+		const int32 Offset = Schema.Fields[FieldIndex].Offset;
+
+		for (int32 i = 0; i < NumRecords; ++i)
+			Out[i] = Read(RecordData[i] + Offset);
+	}
+	else
+	{
+		const int32 NumFields = Schema.Fields.Num();
+		const int32* Offsets = RecordOffsets.GetData() + FieldIndex;
+
+		for (int32 i = 0; i < NumRecords; ++i)
+			Out[i] = Read(RecordData[i] + Offsets[i * NumFields]);
+	}
+}
+
+int32 FPacketColumnDecoder::Decode(TArrayView<const TArrayView<const uint8>> Packets, uint8 PacketType, int32 PayloadOffset)
+{
+	const int32 NumFields = Schema.Fields.Num();
+
+	Records.Reset(Packets.Num());
+	RecordOffsets.Reset();
+
+	if (!Schema.bFixedSize)
+		RecordOffsets.SetNumUninitialized(Packets.Num() * NumFields);
+
+	for (const TArrayView<const uint8>& Packet : Packets)
+	{
+		const int32 Size = Packet.Num() - PayloadOffset;
+
+		if (Packet.Num() == 0 || Packet[0] != PacketType || Size < Schema.MinSize)
+			continue;
+
+		const uint8* Record = Packet.GetData() + PayloadOffset;
+
+		if (!Schema.bFixedSize && Schema.FindFieldOffsets(Record, Size, RecordOffsets.GetData() + Records.Num() * NumFields) == INDEX_NONE)
+			continue;
+
+		Records.Add(Record);
+	}
+
+	for (const FColumn& Column : Columns)
+	{
+		const int32 FieldIndex = Column.FieldIndex;
+		const EDynamicValueType ValueType = Schema.Fields[FieldIndex].ValueType;
+
+		switch (Column.ColumnType)
+		{
+		case EColumnType::Int32:
+			if (ValueType == EDynamicValueType::Int16)
+				FillColumn(*static_cast<TArray<int32>*>(Column.Array), FieldIndex, [](const uint8* Data) { return static_cast<int32>(Load<int16>(Data)); });
+			else
+				FillColumn(*static_cast<TArray<int32>*>(Column.Array), FieldIndex, [](const uint8* Data) { return Load<int32>(Data); });
+			break;
+		case EColumnType::NetId:
+			FillColumn(*static_cast<TArray<FNetId>*>(Column.Array), FieldIndex, [](const uint8* Data) { return FNetId(Load<int32>(Data)); });
+			break;
+		case EColumnType::UInt32:
+			FillColumn(*static_cast<TArray<uint32>*>(Column.Array), FieldIndex, [](const uint8* Data) { return Load<uint32>(Data); });
+			break;
+		case EColumnType::Int64:
+			FillColumn(*static_cast<TArray<int64>*>(Column.Array), FieldIndex, [](const uint8* Data) { return Load<int64>(Data); });
+			break;
+		case EColumnType::Float:
+			FillColumn(*static_cast<TArray<float>*>(Column.Array), FieldIndex, [](const uint8* Data) { return Load<float>(Data); });
+			break;
+		case EColumnType::Double:
+			FillColumn(*static_cast<TArray<double>*>(Column.Array), FieldIndex, [](const uint8* Data) { return Load<double>(Data); });
+			break;
+		case EColumnType::Byte:
+			FillColumn(*static_cast<TArray<uint8>*>(Column.Array), FieldIndex, [](const uint8* Data) { return *Data; });
+			break;
+		case EColumnType::Bool:
+			FillColumn(*static_cast<TArray<bool>*>(Column.Array), FieldIndex, [](const uint8* Data) { return *Data != 0; });
+			break;
+		case EColumnType::Vector:
+			FillColumn(*static_cast<TArray<FVector>*>(Column.Array), FieldIndex, [](const uint8* Data)
+			{
+				return FVector(Load<float>(Data), Load<float>(Data + 4), Load<float>(Data + 8));
+			});
+			break;
+		case EColumnType::Rotator:
+			FillColumn(*static_cast<TArray<FRotator>*>(Column.Array), FieldIndex, [](const uint8* Data)
+			{
+				return FRotator(Load<float>(Data), Load<float>(Data + 4), Load<float>(Data + 8));
+			});
+			break;
+		case EColumnType::String:
+		{
+			TArray<FString>& Strings = *static_cast<TArray<FString>*>(Column.Array);
+			Strings.SetNum(Records.Num());
+
+			for (int32 i = 0; i < Records.Num(); ++i)
+			{
+				const uint8* Data = Records[i] + (Schema.bFixedSize ? Schema.Fields[FieldIndex].Offset : RecordOffsets[i * NumFields + FieldIndex]);
+				FUtf8Codec::DecodeToString(Data + 4, Load<int32>(Data), Strings[i]);
+			}
+			break;
+		}
+		}
+	}
+
+	return Records.Num();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ByteBuffer.h"
+
+// Decodes many packets of one schema column by column into caller-owned arrays, e.g. the views from
+// UByteBuffer::SplitPacketViews. Columns are resized to the number of decoded records and stay index
+// aligned; packets of another type or too short for the schema are skipped. For fixed-size schemas every field sits at the
+// same offset in each record, so each column is filled by one straight loop over the records.
+class CLIENT_API FPacketColumnDecoder
+{
+public:
+	// The schema is referenced, not copied.
+	explicit FPacketColumnDecoder(const FPacketSchema& InSchema);
+
+	// Int32, Int16 and ID fields.
+	bool Bind(const FString& Key, TArray<int32>& Column);
+	bool Bind(const FString& Key, TArray<FNetId>& Column);
+	bool Bind(const FString& Key, TArray<uint32>& Column);
+	bool Bind(const FString& Key, TArray<int64>& Column);
+	bool Bind(const FString& Key, TArray<float>& Column);
+	bool Bind(const FString& Key, TArray<double>& Column);
+	bool Bind(const FString& Key, TArray<uint8>& Column);
+	bool Bind(const FString& Key, TArray<bool>& Column);
+	bool Bind(const FString& Key, TArray<FVector>& Column);
+	bool Bind(const FString& Key, TArray<FRotator>& Column);
+	bool Bind(const FString& Key, TArray<FString>& Column);
+
+	// Only packets whose first byte is PacketType are decoded, so a combined frame carrying several types can be
+	// passed as is. PayloadOffset is where the record starts after that byte. Returns the record count.
+	int32 Decode(TArrayView<const TArrayView<const uint8>> Packets, uint8 PacketType, int32 PayloadOffset = 1);
+
+private:
+	enum class EColumnType : uint8
+	{
+		Int32,
+		NetId,
+		UInt32,
+		Int64,
+		Float,
+		Double,
+		Byte,
+		Bool,
+		Vector,
+		Rotator,
+		String
+	};
+
+	struct FColumn
+	{
+		int32 FieldIndex = INDEX_NONE;
+		EColumnType ColumnType = EColumnType::Int32;
+		void* Array = nullptr;
+	};
+
+	bool BindColumn(const FString& Key, EColumnType ColumnType, void* Array);
+
+	template <typename T, typename ReadFuncType>
+	void FillColumn(TArray<T>& Column, int32 FieldIndex, ReadFuncType Read) const;
+
+	const FPacketSchema& Schema;
+	TArray<FColumn> Columns;
+	TArray<const uint8*> Records;
+	TArray<int32> RecordOffsets;
+};
@@ -0,0 +1,418 @@
+#include "ConnectionManager.h"
+#include "QueueBuffer.h"
+#include "Encryption.h"
+#include "BufferPool.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+struct FShardCommand
+{
+	enum class EKind : uint8
+	{
+		AddConnection,
+		RemoveConnection,
+		Packet
+	};
+
+	EKind Kind = EKind::Packet;
+	int32 Handle = INDEX_NONE;
+	uint8 PacketType = 0;
+	TArray<uint8> Payload;
+	UWebSocket* Socket = nullptr;
+	FString Key;
+};
+
+struct FOutgoingFrame
+{
+	UWebSocket* Socket = nullptr;
+	uint8 PacketType = 0;
+	bool bEncrypted = false;
+	TArray<uint8> Data;
+	// Only set while the socket is capturing and Data is compressed; see UWebSocket::SendFrame.
+	uint8 CapturePacketType = 0;
+	TArray<uint8> CaptureData;
+};
+
+class FConnectionShard final : public FRunnable
+{
+public:
+	FConnectionShard(int32 Index, bool bInSendFromWorker)
+		: bSendFromWorker(bInSendFromWorker)
+	{
+		WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		FlushedEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("ConnectionShard%d"), Index));
+	}
+
+	virtual ~FConnectionShard() override
+	{
+		Stop();
+
+		if (Thread)
+		{
+			Thread->WaitForCompletion();
+			delete Thread;
+		}
+
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		FPlatformProcess::ReturnSynchEventToPool(FlushedEvent);
+		SendFinishedFrames();
+	}
+
+	void Push(FShardCommand&& Command)
+	{
+		Inbox.Enqueue(MoveTemp(Command));
+	}
+
+	void RequestFlush()
+	{
+		bFlushRequested = true;
+		WakeEvent->Trigger();
+	}
+
+	// Blocks until the worker has finished the flush asked for by the last RequestFlush.
+	void WaitForFlush()
+	{
+		FlushedEvent->Wait();
+	}
+
+	// Game thread only, used when the transport's Send must not be called from the worker.
+	void SendFinishedFrames()
+	{
+		FOutgoingFrame Frame;
+
+		while (Outbox.Dequeue(Frame))
+		{
+			Frame.Socket->SendFrame(Frame.PacketType, Frame.Data, Frame.bEncrypted, Frame.CapturePacketType, Frame.CaptureData);
+			FByteBufferPool::Get().Release(MoveTemp(Frame.Data));
+			FByteBufferPool::Get().Release(MoveTemp(Frame.CaptureData));
+		}
+	}
+
+	// Game thread only. Yields the handles whose removal the worker has finished, after their last frames
+	// were sent or placed in the outbox.
+	bool DequeueRemoved(int32& Handle)
+	{
+		return Removed.Dequeue(Handle);
+	}
+
+	virtual uint32 Run() override
+	{
+		while (!bStopping)
+		{
+			WakeEvent->Wait();
+			DrainInbox();
+
+			if (bFlushRequested.exchange(false))
+			{
+				FlushConnections();
+				FlushedEvent->Trigger();
+			}
+		}
+
+		DrainInbox();
+		FlushConnections();
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		bStopping = true;
+		WakeEvent->Trigger();
+	}
+
+private:
+	struct FPendingPacket
+	{
+		uint8 PacketType = 0;
+		TArray<uint8> Payload;
+	};
+
+	// The manager keeps Socket referenced until the removal is acknowledged, so it stays valid here.
+	struct FConnection
+	{
+		UWebSocket* Socket = nullptr;
+		uint8 QueuePacketType = 0;
+		FString Key;
+		TArray<FPendingPacket> Pending;
+	};
+
+	void DrainInbox()
+	{
+		FShardCommand Command;
+
+		while (Inbox.Dequeue(Command))
+		{
+			switch (Command.Kind)
+			{
+			case FShardCommand::EKind::AddConnection:
+			{
+				FConnection& Connection = Connections.Add(Command.Handle);
+				Connection.Socket = Command.Socket;
+				Connection.QueuePacketType = Command.PacketType;
+				Connection.Key = MoveTemp(Command.Key);
+				break;
+			}
+			case FShardCommand::EKind::RemoveConnection:
+				if (FConnection* Connection = Connections.Find(Command.Handle))
+				{
+					FlushConnection(*Connection);
+					Connections.Remove(Command.Handle);
+				}
+
+				Removed.Enqueue(Command.Handle);
+				break;
+			case FShardCommand::EKind::Packet:
+				if (FConnection* Connection = Connections.Find(Command.Handle))
+				{
+					FPendingPacket& Packet = Connection->Pending.AddDefaulted_GetRef();
+					Packet.PacketType = Command.PacketType;
+					Packet.Payload = MoveTemp(Command.Payload);
+				}
+				else
+				{
+					FByteBufferPool::Get().Release(MoveTemp(Command.Payload));
+				}
+				break;
+			}
+		}
+	}
+
+	void FlushConnections()
+	{
+		for (TPair<int32, FConnection>& Pair : Connections)
+			FlushConnection(Pair.Value);
+	}
+
+	// Same framing as UQueueBuffer::SendBuffers: a lone packet goes out on its own, several are combined
+	// under the queue packet type, split so no frame exceeds MaxBufferSize. Either way the frame is built
+	// by the socket so compression applies as it does for SendMessage.
+	void FlushConnection(FConnection& Connection)
+	{
+		UWebSocket* Socket = Connection.Socket;
+		int32 First = 0;
+
+		while (First < Connection.Pending.Num())
+		{
+			int32 Count = 0;
+			int32 Bytes = 1;
+
+			for (int32 i = First; i < Connection.Pending.Num(); ++i)
+			{
+				const int32 ItemBytes = 1 + Connection.Pending[i].Payload.Num() + UQueueBuffer::EndRepeatByte;
+
+				if (Count > 0 && Bytes + ItemBytes > UQueueBuffer::MaxBufferSize)
+					break;
+
+				Bytes += ItemBytes;
+				++Count;
+			}
+
+			TArray<uint8> Combined;
+			uint8 RawPacketType = Connection.Pending[First].PacketType;
+			TArrayView<const uint8> RawPayload = Connection.Pending[First].Payload;
+
+			if (Count > 1)
+			{
+				Combined = FByteBufferPool::Get().Acquire(Bytes);
+
+				for (int32 i = First; i < First + Count; ++i)
+					Socket->AppendCombinedPacket(Combined, Connection.QueuePacketType, Connection.Pending[i].PacketType, Connection.Pending[i].Payload);
+
+				RawPacketType = Connection.QueuePacketType;
+				RawPayload = Combined;
+			}
+
+			TArray<uint8> Frame;
+			TArray<uint8> CaptureFrame;
+			const uint8 PacketType = Socket->BuildFrame(RawPacketType, RawPayload, Frame);
+			Socket->BuildCaptureFrame(RawPacketType, PacketType, RawPayload, Connection.Key, CaptureFrame);
+			FByteBufferPool::Get().Release(MoveTemp(Combined));
+
+			UEncryption::EncryptBufferInPlace(Frame, Connection.Key);
+			SendFrame(Connection, PacketType, MoveTemp(Frame), RawPacketType, MoveTemp(CaptureFrame));
+
+			First += Count;
+		}
+
+		for (FPendingPacket& Packet : Connection.Pending)
+			FByteBufferPool::Get().Release(MoveTemp(Packet.Payload));
+
+		Connection.Pending.Reset();
+	}
+
+	// Goes through UWebSocket::SendFrame so capture, journal and packet log see these frames too.
+	void SendFrame(const FConnection& Connection, uint8 PacketType, TArray<uint8>&& Frame, uint8 CapturePacketType, TArray<uint8>&& CaptureFrame)
+	{
+		if (bSendFromWorker)
+		{
+			Connection.Socket->SendFrame(PacketType, Frame, !Connection.Key.IsEmpty(), CapturePacketType, CaptureFrame);
+			FByteBufferPool::Get().Release(MoveTemp(Frame));
+			FByteBufferPool::Get().Release(MoveTemp(CaptureFrame));
+		}
+		else
+		{
+			FOutgoingFrame Outgoing;
+			Outgoing.Socket = Connection.Socket;
+			Outgoing.PacketType = PacketType;
+			Outgoing.bEncrypted = !Connection.Key.IsEmpty();
+			Outgoing.Data = MoveTemp(Frame);
+			Outgoing.CapturePacketType = CapturePacketType;
+			Outgoing.CaptureData = MoveTemp(CaptureFrame);
+			Outbox.Enqueue(MoveTemp(Outgoing));
+		}
+	}
+
+	const bool bSendFromWorker;
+	FEvent* WakeEvent = nullptr;
+	FEvent* FlushedEvent = nullptr;
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping { false };
+	std::atomic<bool> bFlushRequested { false };
+
+	TQueue<FShardCommand, EQueueMode::Mpsc> Inbox;
+	TQueue<FOutgoingFrame, EQueueMode::Spsc> Outbox;
+	TQueue<int32, EQueueMode::Spsc> Removed;
+	TMap<int32, FConnection> Connections;
+};
+
+void UConnectionManager::Start(int32 NumWorkers, bool bInSendFromWorkers)
+{
+	Shutdown();
+
+	bSendFromWorkers = bInSendFromWorkers;
+	NumWorkers = FMath::Max(1, NumWorkers);
+	Shards.Reserve(NumWorkers);
+
+	for (int32 i = 0; i < NumWorkers; ++i)
+		Shards.Add(MakeShared<FConnectionShard>(i, bSendFromWorkers));
+}
+
+FConnectionShard* UConnectionManager::GetShard(int32 Handle) const
+{
+	return Shards.Num() > 0 && Handle >= 0 ? Shards[Handle % Shards.Num()].Get() : nullptr;
+}
+
+int32 UConnectionManager::AddConnection(UWebSocket* Socket, uint8 QueuePacketType, const FString& Key)
+{
+	if (!Socket || Shards.Num() == 0)
+		return INDEX_NONE;
+
+	const int32 Handle = NextHandle++;
+	Sockets.Add(Handle, Socket);
+
+	FShardCommand Command;
+	Command.Kind = FShardCommand::EKind::AddConnection;
+	Command.Handle = Handle;
+	Command.PacketType = QueuePacketType;
+	Command.Socket = Socket;
+	Command.Key = Key;
+	GetShard(Handle)->Push(MoveTemp(Command));
+
+	return Handle;
+}
+
+void UConnectionManager::RemoveConnection(int32 Handle)
+{
+	FConnectionShard* Shard = GetShard(Handle);
+
+	if (!Shard || !Sockets.Contains(Handle) || PendingRemovals.Contains(Handle))
+		return;
+
+	// The socket stays in Sockets, and so referenced, until the shard acknowledges the removal in Tick.
+	PendingRemovals.Add(Handle);
+
+	FShardCommand Command;
+	Command.Kind = FShardCommand::EKind::RemoveConnection;
+	Command.Handle = Handle;
+	Shard->Push(MoveTemp(Command));
+}
+
+void UConnectionManager::AddBuffer(int32 Handle, uint8 PacketType, UByteBuffer* Buffer)
+{
+	UWebSocket* const* Socket = Sockets.Find(Handle);
+
+	if (!Buffer || !Socket || PendingRemovals.Contains(Handle))
+		return;
+
+	(*Socket)->CommitInternedStrings(Buffer);
+	Enqueue(Handle, PacketType, Buffer->GetBuffer());
+}
+
+void UConnectionManager::Enqueue(int32 Handle, uint8 PacketType, TArrayView<const uint8> Payload)
+{
+	FConnectionShard* Shard = GetShard(Handle);
+
+	if (!Shard)
+		return;
+
+	FShardCommand Command;
+	Command.Handle = Handle;
+	Command.PacketType = PacketType;
+	Command.Payload = FByteBufferPool::Get().Acquire(Payload.Num());
+	Command.Payload.Append(Payload.GetData(), Payload.Num());
+	Shard->Push(MoveTemp(Command));
+}
+
+void UConnectionManager::Tick()
+{
+	for (const TSharedPtr<FConnectionShard>& Shard : Shards)
+		Shard->RequestFlush();
+
+	for (const TSharedPtr<FConnectionShard>& Shard : Shards)
+	{
+		// With game-thread sending, wait for this tick's frames so they go out now rather than next tick.
+		if (!bSendFromWorkers)
+			Shard->WaitForFlush();
+
+		// Acknowledgements are taken before the outbox is drained: the worker queues a connection's last
+		// frames ahead of its acknowledgement, so they are sent before the socket is let go.
+		TArray<int32, TInlineAllocator<8>> RemovedHandles;
+		int32 Handle = INDEX_NONE;
+
+		while (Shard->DequeueRemoved(Handle))
+			RemovedHandles.Add(Handle);
+
+		if (!bSendFromWorkers)
+			Shard->SendFinishedFrames();
+
+		for (int32 RemovedHandle : RemovedHandles)
+		{
+			Sockets.Remove(RemovedHandle);
+			PendingRemovals.Remove(RemovedHandle);
+		}
+	}
+}
+
+void UConnectionManager::Shutdown()
+{
+	Shards.Reset();
+	Sockets.Reset();
+	PendingRemovals.Reset();
+}
+
+int32 UConnectionManager::GetNumConnections() const
+{
+	return Sockets.Num() - PendingRemovals.Num();
+}
+
+int32 UConnectionManager::GetNumWorkers() const
+{
+	return Shards.Num();
+}
+
+void UConnectionManager::BeginDestroy()
+{
+	Shutdown();
+	Super::BeginDestroy();
+}
+
+UConnectionManager* UConnectionManagerFunctionLibrary::CreateConnectionManager(int32 NumWorkers, bool bSendFromWorkers)
+{
+	UConnectionManager* Manager = NewObject<UConnectionManager>();
+	Manager->Start(NumWorkers, bSendFromWorkers);
+	return Manager;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "ByteBuffer.h"
+#include "Websocket.h"
+
+#include "ConnectionManager.generated.h"
+
+class FConnectionShard;
+
+// Owns many socket + queue pairs and shards them across a fixed pool of worker threads. Each connection
+// belongs to exactly one shard, so combining, encrypting and sending never share a lock between shards.
+// Frames go through the socket's own stages: interned strings are committed in AddBuffer, and the workers
+// compress with the socket's dictionaries and encrypt with the connection key. UQueueBuffer pacing and its
+// duplicate filter are not applied; every queued packet is sent on the next flush. Set up compression and
+// interning before adding a socket, and send on it only through the manager while it is added, so interned
+// string references never overtake the literals they point at.
+UCLASS(BlueprintType)
+class CLIENT_API UConnectionManager : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	void Start(int32 NumWorkers, bool bInSendFromWorkers);
+
+	UFUNCTION(BlueprintCallable, Category = "ConnectionManager")
+	int32 AddConnection(UWebSocket* Socket, uint8 QueuePacketType, const FString& Key);
+
+	UFUNCTION(BlueprintCallable, Category = "ConnectionManager")
+	void RemoveConnection(int32 Handle);
+
+	// Commits the buffer's interned strings against the socket's outgoing table, so call it on the game thread.
+	UFUNCTION(BlueprintCallable, Category = "ConnectionManager")
+	void AddBuffer(int32 Handle, uint8 PacketType, UByteBuffer* Buffer);
+
+	// Safe to call from any thread; the payload is copied into pooled storage and sent without interning.
+	void Enqueue(int32 Handle, uint8 PacketType, TArrayView<const uint8> Payload);
+
+	// Asks every shard to flush its queues. With game-thread sending it then waits for the shards and sends
+	// the frames they built, so packets queued before Tick leave during it.
+	UFUNCTION(BlueprintCallable, Category = "ConnectionManager")
+	void Tick();
+
+	UFUNCTION(BlueprintCallable, Category = "ConnectionManager")
+	void Shutdown();
+
+	UFUNCTION(BlueprintPure, Category = "ConnectionManager")
+	int32 GetNumConnections() const;
+
+	UFUNCTION(BlueprintPure, Category = "ConnectionManager")
+	int32 GetNumWorkers() const;
+
+	virtual void BeginDestroy() override;
+
+private:
+	FConnectionShard* GetShard(int32 Handle) const;
+
+	// Keeps the sockets alive for the workers, which hold them as raw pointers.
+	UPROPERTY()
+	TMap<int32, UWebSocket*> Sockets;
+
+	TSet<int32> PendingRemovals;
+
+	TArray<TSharedPtr<FConnectionShard>> Shards;
+	int32 NextHandle = 0;
+	bool bSendFromWorkers = false;
+};
+
+UCLASS(MinimalAPI)
+class UConnectionManagerFunctionLibrary final : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// bSendFromWorkers requires a transport whose Send is thread-safe, such as the loopback transport;
+	// otherwise frames are built on the workers and handed to the game thread for sending in Tick.
+	UFUNCTION(BlueprintCallable, Category = "ConnectionManager")
+	static UConnectionManager* CreateConnectionManager(int32 NumWorkers = 4, bool bSendFromWorkers = false);
+};
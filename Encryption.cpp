@@ -1,5 +1,5 @@
 #include "Encryption.h"
-#include "Misc/Base64.h"
+#include "Base64Codec.h"
 
 TArray<uint8> FStringToByteArray(const FString& String)
 {
@@ -46,7 +46,7 @@ FString UEncryption::Encrypt(const FString& Text, const FString& Key)
 {
     TArray<uint8> TextBytes = FStringToByteArray(Text);
     TArray<uint8> EncryptedBytes = XorOperation(TextBytes, Key);
-    return FBase64::Encode(EncryptedBytes.GetData(), EncryptedBytes.Num());
+    return FBase64Codec::Encode(EncryptedBytes);
 }
 
 TArray<uint8> UEncryption::EncryptBuffer(const TArray<uint8>& TextBytes, const FString& Key)
@@ -60,10 +60,42 @@ TArray<uint8> UEncryption::EncryptBuffer(const TArray<uint8>& TextBytes, const F
     }        
 }
 
+void UEncryption::EncryptBufferInPlace(TArray<uint8>& Bytes, const FString& Key)
+{
+    EncryptInto(Bytes, Key, Bytes);
+}
+
+bool UEncryption::EncryptInto(TArrayView<const uint8> Input, const FString& Key, TArrayView<uint8> Output)
+{
+    const int32 KeyLength = Key.Len();
+
+    if (KeyLength == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Key cannot be empty"));
+        return false;
+    }
+
+    check(Output.Num() >= Input.Num());
+
+    const TCHAR* KeyChars = *Key;
+    const uint8* Source = Input.GetData();
+    uint8* Dest = Output.GetData();
+
+    for (int32 Index = 0, KeyIndex = 0; Index < Input.Num(); ++Index)
+    {
+        Dest[Index] = Source[Index] ^ static_cast<uint8>(KeyChars[KeyIndex]);
+
+        if (++KeyIndex == KeyLength)
+            KeyIndex = 0;
+    }
+
+    return true;
+}
+
 FString UEncryption::Decrypt(const FString& Text, const FString& Key)
 {
     TArray<uint8> DecodedBytes;
-    FBase64::Decode(Text, DecodedBytes);
+    FBase64Codec::Decode(Text, DecodedBytes);
     TArray<uint8> DecryptedBytes = XorOperation(DecodedBytes, Key);
     return ByteArrayToFString(DecryptedBytes);
 }
@@ -19,6 +19,11 @@ public:
     UFUNCTION(BlueprintCallable, Category = "CustomEncryption")
     static FString Decrypt(const FString& Text, const FString& Key);
 
+    static void EncryptBufferInPlace(TArray<uint8>& Bytes, const FString& Key);
+
+    // Output may alias Input and must hold at least Input.Num() bytes, e.g. a UByteBuffer::BeginWrite span.
+    static bool EncryptInto(TArrayView<const uint8> Input, const FString& Key, TArrayView<uint8> Output);
+
 private:
     static FString ShiftBytes(const FString& Text, const FString& Key, bool bEncrypt);
 };
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "FrameArena.h"
+#include "Utf8Codec.h"
+#include "Misc/CoreDelegates.h"
+
+FFrameArena::FFrameArena(int32 InBlockSize)
+	: BlockSize(FMath::Max(InBlockSize, 1024))
+{
+}
+
+FFrameArena::~FFrameArena()
+{
+	for (const FBlock& Block : Blocks)
+		FMemory::Free(Block.Data);
+}
+
+FFrameArena& FFrameArena::GetGameThread()
+{
+	check(IsInGameThread());
+
+	static FFrameArena Arena;
+	static FDelegateHandle EndFrameHandle = FCoreDelegates::OnEndFrame.AddLambda([]() { Arena.Reset(); });
+
+	return Arena;
+}
+
+void* FFrameArena::AllocateSlow(SIZE_T Size, SIZE_T Alignment)
+{
+	// Move on to the next retained block that fits; blocks that are skipped stay unused until the next Reset.
+	while (CurrentBlock + 1 < Blocks.Num())
+	{
+		const FBlock& Block = Blocks[++CurrentBlock];
+		Cursor = Block.Data;
+		End = Block.Data + Block.Size;
+
+		uint8* Aligned = Align(Cursor, Alignment);
+
+		if (Aligned + Size <= End)
+		{
+			Cursor = Aligned + Size;
+			return Aligned;
+		}
+	}
+
+	FBlock& Block = Blocks.AddDefaulted_GetRef();
+	Block.Size = FMath::Max<SIZE_T>(BlockSize, Size + Alignment);
+	Block.Data = static_cast<uint8*>(FMemory::Malloc(Block.Size));
+
+	CurrentBlock = Blocks.Num() - 1;
+	Cursor = Align(Block.Data, Alignment) + Size;
+	End = Block.Data + Block.Size;
+
+	return Cursor - Size;
+}
+
+FStringView FFrameArena::CopyString(FStringView Source)
+{
+	TCHAR* Data = static_cast<TCHAR*>(Allocate(Source.Len() * sizeof(TCHAR), alignof(TCHAR)));
+	FMemory::Memcpy(Data, Source.GetData(), Source.Len() * sizeof(TCHAR));
+	return FStringView(Data, Source.Len());
+}
+
+void FFrameArena::Reset()
+{
+	if (Blocks.Num() == 0)
+		return;
+
+	CurrentBlock = 0;
+	Cursor = Blocks[0].Data;
+	End = Blocks[0].Data + Blocks[0].Size;
+}
+
+int64 FFrameArena::GetBytesReserved() const
+{
+	int64 Total = 0;
+
+	for (const FBlock& Block : Blocks)
+		Total += Block.Size;
+
+	return Total;
+}
+
+bool FArenaRecord::TryDecode(const FPacketSchema& InSchema, TArrayView<const uint8> Bytes, int32& InOutPosition, FFrameArena& Arena, FArenaRecord& OutRecord)
+{
+	const uint8* Data = Bytes.GetData();
+	int32 Position = InOutPosition;
+
+	if (Bytes.Num() - Position < InSchema.MinSize)
+		return false;
+
+	const int32 NumFields = InSchema.Fields.Num();
+	TArrayView<FArenaField> Fields = Arena.AllocateArray<FArenaField>(NumFields);
+
+	for (int32 i = 0; i < NumFields; ++i)
+	{
+		FArenaField& Field = Fields[i];
+		Field.ValueType = InSchema.Fields[i].ValueType;
+
+		switch (Field.ValueType)
+		{
+		case EDynamicValueType::ID:
+		case EDynamicValueType::Int32:
+			Field.IntValue = ByteBufferDetail::Load<int32>(Data + Position);
+			Position += 4;
+			break;
+		case EDynamicValueType::UInt32:
+			Field.IntValue = ByteBufferDetail::Load<uint32>(Data + Position);
+			Position += 4;
+			break;
+		case EDynamicValueType::Float:
+			Field.FloatValues[0] = ByteBufferDetail::Load<float>(Data + Position);
+			Position += 4;
+			break;
+		case EDynamicValueType::Byte:
+			Field.IntValue = Data[Position++];
+			break;
+		case EDynamicValueType::Bool:
+			Field.IntValue = Data[Position++] != 0;
+			break;
+		case EDynamicValueType::Int16:
+			Field.IntValue = ByteBufferDetail::Load<int16>(Data + Position);
+			Position += 2;
+			break;
+		case EDynamicValueType::Int64:
+			Field.IntValue = ByteBufferDetail::Load<int64>(Data + Position);
+			Position += 8;
+			break;
+		case EDynamicValueType::Double:
+			Field.DoubleValue = ByteBufferDetail::Load<double>(Data + Position);
+			Position += 8;
+			break;
+		case EDynamicValueType::Vector:
+		case EDynamicValueType::Rotator:
+			Field.FloatValues[0] = ByteBufferDetail::Load<float>(Data + Position);
+			Field.FloatValues[1] = ByteBufferDetail::Load<float>(Data + Position + 4);
+			Field.FloatValues[2] = ByteBufferDetail::Load<float>(Data + Position + 8);
+			Position += 12;
+			break;
+		case EDynamicValueType::String:
+		{
+			const int32 Length = ByteBufferDetail::Load<int32>(Data + Position);
+			const int32 TailMinSize = (i + 1 < NumFields) ? InSchema.Fields[i + 1].RemainingMinSize : 0;
+			Position += 4;
+
+			if (Length < 0 || Bytes.Num() - Position - TailMinSize < Length)
+				return false;
+
+			TCHAR* Chars = static_cast<TCHAR*>(Arena.Allocate(Length * sizeof(TCHAR), alignof(TCHAR)));
+			Field.StringData = Chars;
+			Field.StringLength = FUtf8Codec::Decode(Data + Position, Length, Chars);
+			Position += Length;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	OutRecord.Schema = &InSchema;
+	OutRecord.Fields = Fields;
+	InOutPosition = Position;
+
+	return true;
+}
+
+const FArenaField* FArenaRecord::FindTyped(int32 Index, EDynamicValueType ValueType) const
+{
+	return Fields.IsValidIndex(Index) && Fields[Index].ValueType == ValueType ? &Fields[Index] : nullptr;
+}
+
+FNetId FArenaRecord::GetNetId(int32 Index) const
+{
+	const FArenaField* Field = FindTyped(Index, EDynamicValueType::ID);
+	return Field ? FNetId(static_cast<int32>(Field->IntValue)) : FNetId();
+}
+
+int32 FArenaRecord::GetInt32(int32 Index) const
+{
+	if (!Fields.IsValidIndex(Index))
+		return 0;
+
+	const FArenaField& Field = Fields[Index];
+	return Field.ValueType == EDynamicValueType::Int32 || Field.ValueType == EDynamicValueType::Int16 ? static_cast<int32>(Field.IntValue) : 0;
+}
+
+uint32 FArenaRecord::GetUInt32(int32 Index) const
+{
+	const FArenaField* Field = FindTyped(Index, EDynamicValueType::UInt32);
+	return Field ? static_cast<uint32>(Field->IntValue) : 0;
+}
+
+int64 FArenaRecord::GetInt64(int32 Index) const
+{
+	const FArenaField* Field = FindTyped(Index, EDynamicValueType::Int64);
+	return Field ? Field->IntValue : 0;
+}
+
+float FArenaRecord::GetFloat(int32 Index) const
+{
+	const FArenaField* Field = FindTyped(Index, EDynamicValueType::Float);
+	return Field ? Field->FloatValues[0] : 0.0f;
+}
+
+double FArenaRecord::GetDouble(int32 Index) const
+{
+	const FArenaField* Field = FindTyped(Index, EDynamicValueType::Double);
+	return Field ? Field->DoubleValue : 0.0;
+}
+
+uint8 FArenaRecord::GetByte(int32 Index) const
+{
+	const FArenaField* Field = FindTyped(Index, EDynamicValueType::Byte);
+	return Field ? static_cast<uint8>(Field->IntValue) : 0;
+}
+
+bool FArenaRecord::GetBool(int32 Index) const
+{
+	const FArenaField* Field = FindTyped(Index, EDynamicValueType::Bool);
+	return Field ? Field->IntValue != 0 : false;
+}
+
+FVector FArenaRecord::GetVector(int32 Index) const
+{
+	const FArenaField* Field = FindTyped(Index, EDynamicValueType::Vector);
+	return Field ? FVector(Field->FloatValues[0], Field->FloatValues[1], Field->FloatValues[2]) : FVector::ZeroVector;
+}
+
+FRotator FArenaRecord::GetRotator(int32 Index) const
+{
+	const FArenaField* Field = FindTyped(Index, EDynamicValueType::Rotator);
+	return Field ? FRotator(Field->FloatValues[0], Field->FloatValues[1], Field->FloatValues[2]) : FRotator::ZeroRotator;
+}
+
+FStringView FArenaRecord::GetString(int32 Index) const
+{
+	const FArenaField* Field = FindTyped(Index, EDynamicValueType::String);
+	return Field ? FStringView(Field->StringData, Field->StringLength) : FStringView();
+}
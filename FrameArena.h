@@ -0,0 +1,120 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ByteBuffer.h"
+#include <type_traits>
+
+// Bump allocator for decode temporaries that die together. Allocation is a pointer bump inside the current
+// block, and Reset rewinds to the first block in O(1) while keeping every block for reuse. Nothing is ever
+// destructed, so only trivially destructible types may be placed in it.
+class CLIENT_API FFrameArena
+{
+public:
+	static constexpr int32 DefaultBlockSize = 64 * 1024;
+
+	explicit FFrameArena(int32 InBlockSize = DefaultBlockSize);
+	~FFrameArena();
+
+	FFrameArena(const FFrameArena&) = delete;
+	FFrameArena& operator=(const FFrameArena&) = delete;
+
+	// Game-thread arena, reset at the end of every engine frame. Anything taken from it is only valid
+	// until then.
+	static FFrameArena& GetGameThread();
+
+	FORCEINLINE void* Allocate(SIZE_T Size, SIZE_T Alignment = 8)
+	{
+		uint8* Aligned = Align(Cursor, Alignment);
+
+		if (Aligned + Size <= End)
+		{
+			Cursor = Aligned + Size;
+			return Aligned;
+		}
+
+		return AllocateSlow(Size, Alignment);
+	}
+
+	template <typename T>
+	TArrayView<T> AllocateArray(int32 Num)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "FFrameArena never runs destructors");
+
+		T* Data = static_cast<T*>(Allocate(sizeof(T) * Num, alignof(T)));
+		DefaultConstructItems<T>(Data, Num);
+		return TArrayView<T>(Data, Num);
+	}
+
+	template <typename T, typename... ArgTypes>
+	T* New(ArgTypes&&... Args)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "FFrameArena never runs destructors");
+
+		return new (Allocate(sizeof(T), alignof(T))) T(Forward<ArgTypes>(Args)...);
+	}
+
+	FStringView CopyString(FStringView Source);
+
+	void Reset();
+
+	int64 GetBytesReserved() const;
+
+private:
+	struct FBlock
+	{
+		uint8* Data = nullptr;
+		SIZE_T Size = 0;
+	};
+
+	void* AllocateSlow(SIZE_T Size, SIZE_T Alignment);
+
+	TArray<FBlock> Blocks;
+	int32 CurrentBlock = INDEX_NONE;
+	uint8* Cursor = nullptr;
+	uint8* End = nullptr;
+	int32 BlockSize;
+};
+
+struct FArenaField
+{
+	EDynamicValueType ValueType = EDynamicValueType::None;
+	int32 StringLength = 0;
+
+	union
+	{
+		int64 IntValue;
+		double DoubleValue;
+		float FloatValues[3];
+		const TCHAR* StringData;
+	};
+};
+
+// Read-only decode result whose fields and strings live in an FFrameArena. The schema is referenced, not
+// copied, and must outlive the record.
+class CLIENT_API FArenaRecord
+{
+public:
+	static bool TryDecode(const FPacketSchema& InSchema, TArrayView<const uint8> Bytes, int32& InOutPosition, FFrameArena& Arena, FArenaRecord& OutRecord);
+
+	int32 Num() const { return Fields.Num(); }
+	int32 FindField(const FString& Key) const { return Schema ? Schema->FindField(Key) : INDEX_NONE; }
+	EDynamicValueType GetType(int32 Index) const { return Fields.IsValidIndex(Index) ? Fields[Index].ValueType : EDynamicValueType::None; }
+
+	FNetId GetNetId(int32 Index) const;
+	int32 GetInt32(int32 Index) const;
+	uint32 GetUInt32(int32 Index) const;
+	int64 GetInt64(int32 Index) const;
+	float GetFloat(int32 Index) const;
+	double GetDouble(int32 Index) const;
+	uint8 GetByte(int32 Index) const;
+	bool GetBool(int32 Index) const;
+	FVector GetVector(int32 Index) const;
+	FRotator GetRotator(int32 Index) const;
+	FStringView GetString(int32 Index) const;
+
+private:
+	const FArenaField* FindTyped(int32 Index, EDynamicValueType ValueType) const;
+
+	const FPacketSchema* Schema = nullptr;
+	TArrayView<const FArenaField> Fields;
+};
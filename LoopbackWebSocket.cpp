@@ -0,0 +1,180 @@
+#include "LoopbackWebSocket.h"
+#include "Misc/ScopeLock.h"
+
+static FCriticalSection GLoopbackRegistryLock;
+static TArray<TWeakPtr<FLoopbackWebSocket>> GLoopbackRegistry;
+
+TSharedRef<FLoopbackWebSocket> FLoopbackWebSocket::CreateEcho()
+{
+	TSharedRef<FLoopbackWebSocket> Socket = MakeShared<FLoopbackWebSocket>();
+	Socket->bEcho = true;
+	Register(Socket);
+	return Socket;
+}
+
+void FLoopbackWebSocket::CreatePair(TSharedPtr<FLoopbackWebSocket>& OutClient, TSharedPtr<FLoopbackWebSocket>& OutServer)
+{
+	TSharedRef<FLoopbackWebSocket> Client = MakeShared<FLoopbackWebSocket>();
+	TSharedRef<FLoopbackWebSocket> Server = MakeShared<FLoopbackWebSocket>();
+
+	Client->Peer = Server;
+	Server->Peer = Client;
+
+	Register(Client);
+	Register(Server);
+
+	OutClient = Client;
+	OutServer = Server;
+}
+
+void FLoopbackWebSocket::Register(const TSharedRef<FLoopbackWebSocket>& Socket)
+{
+	FScopeLock ScopeLock(&GLoopbackRegistryLock);
+	GLoopbackRegistry.Add(Socket);
+}
+
+int32 FLoopbackWebSocket::PumpAll()
+{
+	TArray<TSharedPtr<FLoopbackWebSocket>> Sockets;
+
+	{
+		FScopeLock ScopeLock(&GLoopbackRegistryLock);
+		Sockets.Reserve(GLoopbackRegistry.Num());
+
+		for (int32 i = GLoopbackRegistry.Num() - 1; i >= 0; --i)
+		{
+			TSharedPtr<FLoopbackWebSocket> Socket = GLoopbackRegistry[i].Pin();
+
+			if (Socket)
+				Sockets.Add(MoveTemp(Socket));
+			else
+				GLoopbackRegistry.RemoveAtSwap(i);
+		}
+	}
+
+	int32 Delivered = 0;
+
+	for (const TSharedPtr<FLoopbackWebSocket>& Socket : Sockets)
+		Delivered += Socket->Pump();
+
+	return Delivered;
+}
+
+int32 FLoopbackWebSocket::Pump()
+{
+	TArray<FPendingEvent> Delivering;
+
+	{
+		FScopeLock ScopeLock(&InboxLock);
+		Swap(Inbox, Delivering);
+	}
+
+	for (FPendingEvent& Event : Delivering)
+	{
+		switch (Event.Kind)
+		{
+		case EEventKind::Connected:
+			ConnectedEvent.Broadcast();
+			break;
+		case EEventKind::Closed:
+			ClosedEvent.Broadcast(Event.StatusCode, Event.Text, true);
+			break;
+		case EEventKind::Text:
+			MessageEvent.Broadcast(Event.Text);
+			break;
+		case EEventKind::Binary:
+			RawMessageEvent.Broadcast(Event.Data.GetData(), Event.Data.Num(), 0);
+			BinaryMessageEvent.Broadcast(Event.Data.GetData(), Event.Data.Num(), true);
+			break;
+		case EEventKind::TextSent:
+			MessageSentEvent.Broadcast(Event.Text);
+			break;
+		}
+	}
+
+	return Delivering.Num();
+}
+
+void FLoopbackWebSocket::Connect()
+{
+	bConnected = true;
+
+	FPendingEvent Event;
+	Event.Kind = EEventKind::Connected;
+	Enqueue(MoveTemp(Event));
+}
+
+void FLoopbackWebSocket::Close(int32 Code, const FString& Reason)
+{
+	if (!bConnected.exchange(false))
+		return;
+
+	FPendingEvent Event;
+	Event.Kind = EEventKind::Closed;
+	Event.StatusCode = Code;
+	Event.Text = Reason;
+
+	if (TSharedPtr<FLoopbackWebSocket> Target = Peer.Pin())
+	{
+		if (Target->bConnected.exchange(false))
+			Target->Enqueue(FPendingEvent(Event));
+	}
+
+	Enqueue(MoveTemp(Event));
+}
+
+bool FLoopbackWebSocket::IsConnected()
+{
+	return bConnected;
+}
+
+TSharedPtr<FLoopbackWebSocket> FLoopbackWebSocket::GetTarget()
+{
+	if (!bConnected)
+		return nullptr;
+
+	return bEcho ? TSharedPtr<FLoopbackWebSocket>(AsShared()) : Peer.Pin();
+}
+
+void FLoopbackWebSocket::Send(const FString& Data)
+{
+	if (TSharedPtr<FLoopbackWebSocket> Target = GetTarget())
+	{
+		FPendingEvent Event;
+		Event.Kind = EEventKind::Text;
+		Event.Text = Data;
+		Target->Enqueue(MoveTemp(Event));
+
+		FPendingEvent Sent;
+		Sent.Kind = EEventKind::TextSent;
+		Sent.Text = Data;
+		Enqueue(MoveTemp(Sent));
+	}
+}
+
+void FLoopbackWebSocket::Send(const void* Data, SIZE_T Size, bool bIsBinary)
+{
+	if (TSharedPtr<FLoopbackWebSocket> Target = GetTarget())
+	{
+		FPendingEvent Event;
+		Event.Kind = bIsBinary ? EEventKind::Binary : EEventKind::Text;
+
+		if (bIsBinary)
+		{
+			Event.Data.Append(static_cast<const uint8*>(Data), static_cast<int32>(Size));
+		}
+		else
+		{
+			FUTF8ToTCHAR Convert(static_cast<const ANSICHAR*>(Data), static_cast<int32>(Size));
+			Event.Text = FString(Convert.Length(), Convert.Get());
+		}
+
+		Target->Enqueue(MoveTemp(Event));
+	}
+}
+
+void FLoopbackWebSocket::Enqueue(FPendingEvent&& Event)
+{
+	FScopeLock ScopeLock(&InboxLock);
+	Inbox.Add(MoveTemp(Event));
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IWebSocket.h"
+#include "HAL/CriticalSection.h"
+#include "Runtime/Launch/Resources/Version.h"
+#include <atomic>
+
+// In-process IWebSocket. An echo socket delivers everything it sends back to itself, a pair delivers to
+// its peer. Send is thread-safe; events are raised on whichever thread calls Pump/PumpAll.
+class FLoopbackWebSocket final : public IWebSocket, public TSharedFromThis<FLoopbackWebSocket>
+{
+public:
+	static TSharedRef<FLoopbackWebSocket> CreateEcho();
+	static void CreatePair(TSharedPtr<FLoopbackWebSocket>& OutClient, TSharedPtr<FLoopbackWebSocket>& OutServer);
+
+	static int32 PumpAll();
+	int32 Pump();
+
+	virtual void Connect() override;
+	virtual void Close(int32 Code = 1000, const FString& Reason = FString()) override;
+	virtual bool IsConnected() override;
+	virtual void Send(const FString& Data) override;
+	virtual void Send(const void* Data, SIZE_T Size, bool bIsBinary = false) override;
+
+#if ENGINE_MAJOR_VERSION > 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 3)
+	virtual void SetTextMessageMemoryLimit(uint64 TextMessageMemoryLimit) override {}
+#endif
+
+	virtual FWebSocketConnectedEvent& OnConnected() override { return ConnectedEvent; }
+	virtual FWebSocketConnectionErrorEvent& OnConnectionError() override { return ConnectionErrorEvent; }
+	virtual FWebSocketClosedEvent& OnClosed() override { return ClosedEvent; }
+	virtual FWebSocketMessageEvent& OnMessage() override { return MessageEvent; }
+	virtual FWebSocketBinaryMessageEvent& OnBinaryMessage() override { return BinaryMessageEvent; }
+	virtual FWebSocketRawMessageEvent& OnRawMessage() override { return RawMessageEvent; }
+	virtual FWebSocketMessageSentEvent& OnMessageSent() override { return MessageSentEvent; }
+
+private:
+	enum class EEventKind : uint8
+	{
+		Connected,
+		Closed,
+		Text,
+		Binary,
+		TextSent
+	};
+
+	struct FPendingEvent
+	{
+		EEventKind Kind = EEventKind::Binary;
+		int32 StatusCode = 0;
+		FString Text;
+		TArray<uint8> Data;
+	};
+
+	static void Register(const TSharedRef<FLoopbackWebSocket>& Socket);
+
+	TSharedPtr<FLoopbackWebSocket> GetTarget();
+	void Enqueue(FPendingEvent&& Event);
+
+	FCriticalSection InboxLock;
+	TArray<FPendingEvent> Inbox;
+
+	TWeakPtr<FLoopbackWebSocket> Peer;
+	bool bEcho = false;
+	std::atomic<bool> bConnected { false };
+
+	FWebSocketConnectedEvent ConnectedEvent;
+	FWebSocketConnectionErrorEvent ConnectionErrorEvent;
+	FWebSocketClosedEvent ClosedEvent;
+	FWebSocketMessageEvent MessageEvent;
+	FWebSocketBinaryMessageEvent BinaryMessageEvent;
+	FWebSocketRawMessageEvent RawMessageEvent;
+	FWebSocketMessageSentEvent MessageSentEvent;
+};
@@ -0,0 +1,129 @@
+#include "NetStringTable.h"
+
+FNetStringTable::FNetStringTable(int32 InCapacity)
+	: Capacity(FMath::Max(1, InCapacity))
+{
+	Entries.Reserve(Capacity);
+	Lookup.Reserve(Capacity);
+}
+
+int32 FNetStringTable::FindOrAssign(const FString& Value, bool& bOutKnown)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (const int32* Existing = Lookup.Find(Value))
+	{
+		bOutKnown = true;
+		Touch(*Existing);
+		return *Existing;
+	}
+
+	bOutKnown = false;
+
+	int32 Index;
+
+	if (Entries.Num() < Capacity)
+	{
+		Index = Entries.AddDefaulted();
+	}
+	else
+	{
+		Index = Tail;
+		Unlink(Index);
+		Lookup.Remove(Entries[Index].Value);
+	}
+
+	FEntry& Entry = Entries[Index];
+	Entry.Value = Value;
+	Entry.bUsed = true;
+	Lookup.Add(Value, Index);
+	LinkFront(Index);
+
+	return Index;
+}
+
+bool FNetStringTable::Store(int32 Index, const FString& Value)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (Index < 0 || Index >= Capacity)
+		return false;
+
+	if (Index >= Entries.Num())
+		Entries.SetNum(Index + 1);
+
+	FEntry& Entry = Entries[Index];
+
+	if (Entry.bUsed)
+		Unlink(Index);
+
+	Entry.Value = Value;
+	Entry.bUsed = true;
+	LinkFront(Index);
+
+	return true;
+}
+
+bool FNetStringTable::Find(int32 Index, FString& OutValue)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (!Entries.IsValidIndex(Index) || !Entries[Index].bUsed)
+		return false;
+
+	Touch(Index);
+	OutValue = Entries[Index].Value;
+	return true;
+}
+
+void FNetStringTable::Reset()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	Entries.Reset();
+	Lookup.Reset();
+	Head = INDEX_NONE;
+	Tail = INDEX_NONE;
+}
+
+void FNetStringTable::Unlink(int32 Index)
+{
+	FEntry& Entry = Entries[Index];
+
+	if (Entry.Prev != INDEX_NONE)
+		Entries[Entry.Prev].Next = Entry.Next;
+	else
+		Head = Entry.Next;
+
+	if (Entry.Next != INDEX_NONE)
+		Entries[Entry.Next].Prev = Entry.Prev;
+	else
+		Tail = Entry.Prev;
+
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = INDEX_NONE;
+}
+
+void FNetStringTable::LinkFront(int32 Index)
+{
+	FEntry& Entry = Entries[Index];
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = Head;
+
+	if (Head != INDEX_NONE)
+		Entries[Head].Prev = Index;
+
+	Head = Index;
+
+	if (Tail == INDEX_NONE)
+		Tail = Index;
+}
+
+void FNetStringTable::Touch(int32 Index)
+{
+	if (Head != Index)
+	{
+		Unlink(Index);
+		LinkFront(Index);
+	}
+}
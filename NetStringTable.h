@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+// One direction of a per-connection string table. The sending side decides which slot each string lives in,
+// evicting the least recently used entry when full; the receiving side only stores what the sender assigns,
+// so both stay in sync as long as packets are decoded in the order they were sent. The sender only assigns
+// slots when a buffer is handed to the socket (UByteBuffer::CommitInternedStrings). All calls are locked.
+class CLIENT_API FNetStringTable
+{
+public:
+	static constexpr int32 DefaultCapacity = 1024;
+
+	explicit FNetStringTable(int32 InCapacity = DefaultCapacity);
+
+	int32 GetCapacity() const { return Capacity; }
+
+	// Sender: returns the slot for Value; bOutKnown is false when the peer has not seen it in that slot yet.
+	int32 FindOrAssign(const FString& Value, bool& bOutKnown);
+
+	// Receiver: records the string the sender assigned to Index.
+	bool Store(int32 Index, const FString& Value);
+	bool Find(int32 Index, FString& OutValue);
+
+	void Reset();
+
+private:
+	struct FCaseSensitiveKeyFuncs : TDefaultMapKeyFuncs<FString, int32, false>
+	{
+		static FORCEINLINE bool Matches(const FString& A, const FString& B) { return A.Equals(B, ESearchCase::CaseSensitive); }
+		static FORCEINLINE uint32 GetKeyHash(const FString& Key) { return FCrc::StrCrc32(*Key); }
+	};
+
+	struct FEntry
+	{
+		FString Value;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+		bool bUsed = false;
+	};
+
+	void Unlink(int32 Index);
+	void LinkFront(int32 Index);
+	void Touch(int32 Index);
+
+	FCriticalSection Lock;
+	int32 Capacity;
+	TArray<FEntry> Entries;
+	TMap<FString, int32, FDefaultSetAllocator, FCaseSensitiveKeyFuncs> Lookup;
+	int32 Head = INDEX_NONE;
+	int32 Tail = INDEX_NONE;
+};
@@ -0,0 +1,393 @@
+#include "PacketCompression.h"
+#include "ByteBuffer.h"
+#include "TrafficCapture.h"
+#include "Encryption.h"
+#include "Misc/FileHelper.h"
+
+namespace
+{
+	constexpr uint32 DictionaryMagic = 0x44424255; // "UBBD"
+	constexpr uint16 DictionaryVersion = 1;
+	constexpr int32 DictionaryHeaderSize = 12;
+	constexpr int32 MaxDistance = 0xFFFF;
+	constexpr int32 LocalHashBits = 8;
+
+	FORCEINLINE uint32 HashBytes(const uint8* Data, int32 Bits)
+	{
+		return (ByteBufferDetail::Load<uint32>(Data) * 2654435761u) >> (32 - Bits);
+	}
+
+	FORCEINLINE int32 CountMatch(const uint8* A, const uint8* B, int32 Limit)
+	{
+		int32 Length = 0;
+
+		while (Length < Limit && A[Length] == B[Length])
+			++Length;
+
+		return Length;
+	}
+
+	FORCEINLINE void WriteLength(uint8*& Out, int32 Length)
+	{
+		for (; Length >= 255; Length -= 255)
+			*Out++ = 255;
+
+		*Out++ = static_cast<uint8>(Length);
+	}
+
+	FORCEINLINE bool ReadLength(const uint8*& In, const uint8* End, int32& InOutLength)
+	{
+		uint8 Byte;
+
+		do
+		{
+			if (In == End)
+				return false;
+
+			Byte = *In++;
+			InOutLength += Byte;
+		} while (Byte == 255);
+
+		return true;
+	}
+
+	void WriteSequence(uint8*& Out, const uint8* Literals, int32 NumLiterals, int32 Distance, int32 MatchLength)
+	{
+		const int32 MatchCode = MatchLength > 0 ? MatchLength - FPacketDictionary::MinMatch : 0;
+		*Out++ = static_cast<uint8>((FMath::Min(NumLiterals, 15) << 4) | FMath::Min(MatchCode, 15));
+
+		if (NumLiterals >= 15)
+			WriteLength(Out, NumLiterals - 15);
+
+		FMemory::Memcpy(Out, Literals, NumLiterals);
+		Out += NumLiterals;
+
+		if (MatchLength == 0)
+			return;
+
+		ByteBufferDetail::Store<uint16>(Out, static_cast<uint16>(Distance));
+		Out += 2;
+
+		if (MatchCode >= 15)
+			WriteLength(Out, MatchCode - 15);
+	}
+}
+
+FPacketDictionary::FPacketDictionary(uint16 InId, uint8 InPacketType, TArray<uint8>&& InContent)
+	: Id(InId)
+	, PacketType(InPacketType)
+	, Content(MoveTemp(InContent))
+{
+	if (Content.Num() > MaxContentSize)
+		Content.RemoveAt(0, Content.Num() - MaxContentSize);
+
+	HashHeads.Init(INDEX_NONE, 1 << HashBits);
+	HashChain.Init(INDEX_NONE, Content.Num());
+
+	for (int32 Position = 0; Position + MinMatch <= Content.Num(); ++Position)
+	{
+		int32& Head = HashHeads[HashBytes(Content.GetData() + Position, HashBits)];
+		HashChain[Position] = Head;
+		Head = Position;
+	}
+}
+
+int32 FPacketDictionary::Compress(TArrayView<const uint8> Source, uint8* Dest) const
+{
+	const uint8* Input = Source.GetData();
+	const int32 InputSize = Source.Num();
+	const int32 DictionarySize = Content.Num();
+
+	// Positions inside the packet itself, stored plus one so that zero means empty.
+	uint16 LocalHeads[1 << LocalHashBits] = {};
+
+	uint8* Out = Dest;
+	int32 Anchor = 0;
+	int32 Position = 0;
+
+	while (Position + MinMatch <= InputSize)
+	{
+		const int32 Limit = InputSize - Position;
+		int32 BestLength = 0;
+		int32 BestDistance = 0;
+
+		uint16& LocalHead = LocalHeads[HashBytes(Input + Position, LocalHashBits)];
+
+		if (LocalHead != 0)
+		{
+			const int32 Candidate = LocalHead - 1;
+			const int32 Length = CountMatch(Input + Candidate, Input + Position, Limit);
+
+			if (Length >= MinMatch && Position - Candidate <= MaxDistance)
+			{
+				BestLength = Length;
+				BestDistance = Position - Candidate;
+			}
+		}
+
+		LocalHead = static_cast<uint16>(FMath::Min(Position + 1, 0xFFFF));
+
+		int32 Candidate = HashHeads[HashBytes(Input + Position, HashBits)];
+
+		for (int32 Depth = 0; Candidate != INDEX_NONE && Depth < MaxChainDepth; ++Depth, Candidate = HashChain[Candidate])
+		{
+			const int32 Distance = DictionarySize - Candidate + Position;
+
+			if (Distance > MaxDistance)
+				break;
+
+			const int32 Length = CountMatch(Content.GetData() + Candidate, Input + Position, FMath::Min(Limit, DictionarySize - Candidate));
+
+			if (Length > BestLength)
+			{
+				BestLength = Length;
+				BestDistance = Distance;
+			}
+		}
+
+		if (BestLength < MinMatch)
+		{
+			++Position;
+			continue;
+		}
+
+		WriteSequence(Out, Input + Anchor, Position - Anchor, BestDistance, BestLength);
+
+		const int32 MatchEnd = Position + BestLength;
+
+		for (++Position; Position < MatchEnd && Position + MinMatch <= InputSize; ++Position)
+			LocalHeads[HashBytes(Input + Position, LocalHashBits)] = static_cast<uint16>(FMath::Min(Position + 1, 0xFFFF));
+
+		Position = MatchEnd;
+		Anchor = MatchEnd;
+	}
+
+	if (Anchor < InputSize || InputSize == 0)
+		WriteSequence(Out, Input + Anchor, InputSize - Anchor, 0, 0);
+
+	return static_cast<int32>(Out - Dest);
+}
+
+bool FPacketDictionary::Decompress(TArrayView<const uint8> Source, uint8* Dest, int32 RawSize) const
+{
+	const uint8* In = Source.GetData();
+	const uint8* const End = In + Source.Num();
+	const int32 DictionarySize = Content.Num();
+	int32 Written = 0;
+
+	while (true)
+	{
+		if (In == End)
+			return false;
+
+		const uint8 Token = *In++;
+		int32 NumLiterals = Token >> 4;
+
+		if (NumLiterals == 15 && !ReadLength(In, End, NumLiterals))
+			return false;
+
+		if (NumLiterals > End - In || NumLiterals > RawSize - Written)
+			return false;
+
+		FMemory::Memcpy(Dest + Written, In, NumLiterals);
+		In += NumLiterals;
+		Written += NumLiterals;
+
+		if (Written == RawSize)
+			return In == End;
+
+		if (End - In < 2)
+			return false;
+
+		const int32 Distance = ByteBufferDetail::Load<uint16>(In);
+		In += 2;
+
+		int32 MatchLength = Token & 0x0F;
+
+		if (MatchLength == 15 && !ReadLength(In, End, MatchLength))
+			return false;
+
+		MatchLength += MinMatch;
+
+		if (Distance == 0 || Distance > Written + DictionarySize || MatchLength > RawSize - Written)
+			return false;
+
+		// The match may start in the dictionary and run on into the output, and may overlap itself.
+		int32 From = Written - Distance;
+
+		for (int32 i = 0; i < MatchLength; ++i, ++From)
+			Dest[Written + i] = From < 0 ? Content[DictionarySize + From] : Dest[From];
+
+		Written += MatchLength;
+
+		if (Written == RawSize)
+			return In == End;
+	}
+}
+
+bool FPacketDictionary::SaveToFile(const FString& FilePath) const
+{
+	TArray<uint8> Bytes;
+	Bytes.SetNumUninitialized(DictionaryHeaderSize + Content.Num());
+
+	ByteBufferDetail::Store<uint32>(Bytes.GetData(), DictionaryMagic);
+	ByteBufferDetail::Store<uint16>(Bytes.GetData() + 4, DictionaryVersion);
+	ByteBufferDetail::Store<uint16>(Bytes.GetData() + 6, Id);
+	Bytes[8] = PacketType;
+	Bytes[9] = 0;
+	ByteBufferDetail::Store<uint16>(Bytes.GetData() + 10, 0);
+	FMemory::Memcpy(Bytes.GetData() + DictionaryHeaderSize, Content.GetData(), Content.Num());
+
+	return FFileHelper::SaveArrayToFile(Bytes, *FilePath);
+}
+
+TSharedPtr<FPacketDictionary> FPacketDictionary::LoadFromFile(const FString& FilePath)
+{
+	TArray<uint8> Bytes;
+
+	if (!FFileHelper::LoadFileToArray(Bytes, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to read packet dictionary %s"), *FilePath);
+		return nullptr;
+	}
+
+	if (Bytes.Num() < DictionaryHeaderSize
+		|| ByteBufferDetail::Load<uint32>(Bytes.GetData()) != DictionaryMagic
+		|| ByteBufferDetail::Load<uint16>(Bytes.GetData() + 4) != DictionaryVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s is not a packet dictionary"), *FilePath);
+		return nullptr;
+	}
+
+	const uint16 DictionaryId = ByteBufferDetail::Load<uint16>(Bytes.GetData() + 6);
+	const uint8 DictionaryPacketType = Bytes[8];
+	Bytes.RemoveAt(0, DictionaryHeaderSize);
+
+	return MakeShared<FPacketDictionary>(DictionaryId, DictionaryPacketType, MoveTemp(Bytes));
+}
+
+TArray<uint8> FPacketDictionaryTrainer::Train(TArrayView<const TArrayView<const uint8>> Samples, int32 DictionarySize)
+{
+	DictionarySize = FMath::Clamp(DictionarySize, 0, FPacketDictionary::MaxContentSize);
+
+	auto DmerAt = [](const uint8* Data)
+	{
+		uint64 Value = 0;
+		FMemory::Memcpy(&Value, Data, DmerSize);
+		return Value;
+	};
+
+	TMap<uint64, int32> Frequencies;
+
+	for (const TArrayView<const uint8>& Sample : Samples)
+	{
+		for (int32 i = 0; i + DmerSize <= Sample.Num(); ++i)
+			++Frequencies.FindOrAdd(DmerAt(Sample.GetData() + i));
+	}
+
+	TArray<TArrayView<const uint8>> Picked;
+	int32 PickedBytes = 0;
+
+	while (PickedBytes < DictionarySize)
+	{
+		int32 BestScore = 0;
+		int32 BestSample = INDEX_NONE;
+		int32 BestStart = 0;
+		int32 BestLength = 0;
+
+		for (int32 SampleIndex = 0; SampleIndex < Samples.Num(); ++SampleIndex)
+		{
+			const TArrayView<const uint8>& Sample = Samples[SampleIndex];
+			const int32 Length = FMath::Min(SegmentSize, Sample.Num());
+			const int32 DmersPerSegment = Length - DmerSize + 1;
+
+			if (DmersPerSegment <= 0)
+				continue;
+
+			// Sliding window over the d-mer frequencies of every segment start in this sample.
+			int32 Score = 0;
+
+			for (int32 i = 0; i < DmersPerSegment; ++i)
+				Score += Frequencies.FindRef(DmerAt(Sample.GetData() + i));
+
+			for (int32 Start = 0; ; ++Start)
+			{
+				if (Score > BestScore)
+				{
+					BestScore = Score;
+					BestSample = SampleIndex;
+					BestStart = Start;
+					BestLength = Length;
+				}
+
+				if (Start + Length >= Sample.Num())
+					break;
+
+				Score -= Frequencies.FindRef(DmerAt(Sample.GetData() + Start));
+				Score += Frequencies.FindRef(DmerAt(Sample.GetData() + Start + DmersPerSegment));
+			}
+		}
+
+		if (BestSample == INDEX_NONE)
+			break;
+
+		const TArrayView<const uint8> Segment = Samples[BestSample].Slice(BestStart, BestLength);
+
+		for (int32 i = 0; i + DmerSize <= Segment.Num(); ++i)
+			Frequencies.Add(DmerAt(Segment.GetData() + i), 0);
+
+		Picked.Add(Segment);
+		PickedBytes += Segment.Num();
+	}
+
+	TArray<uint8> Dictionary;
+	Dictionary.Reserve(PickedBytes);
+
+	for (int32 i = Picked.Num() - 1; i >= 0; --i)
+		Dictionary.Append(Picked[i].GetData(), Picked[i].Num());
+
+	if (Dictionary.Num() > DictionarySize)
+		Dictionary.RemoveAt(0, Dictionary.Num() - DictionarySize);
+
+	return Dictionary;
+}
+
+bool UPacketCompressionFunctionLibrary::TrainDictionaryFromCapture(const FString& CapturePath, uint8 PacketType, int32 DictionaryId, const FString& OutputPath, int32 DictionarySize, const FString& Key)
+{
+	FTrafficCaptureReader Reader;
+
+	if (!Reader.Open(CapturePath))
+		return false;
+
+	TArray<TArrayView<const uint8>> Samples;
+	TArray<TArray<uint8>> Decrypted;
+
+	for (const FTrafficCaptureFrame& Frame : Reader.GetFrames())
+	{
+		if (Frame.PacketType != PacketType || Frame.Data.Num() <= 1)
+			continue;
+
+		if (!Frame.bEncrypted)
+		{
+			Samples.Add(Frame.Data.RightChop(1));
+			continue;
+		}
+
+		if (Key.IsEmpty())
+			continue;
+
+		TArray<uint8>& Plain = Decrypted.AddDefaulted_GetRef();
+		Plain.SetNumUninitialized(Frame.Data.Num());
+		UEncryption::EncryptInto(Frame.Data, Key, Plain);
+		Samples.Add(TArrayView<const uint8>(Plain).RightChop(1));
+	}
+
+	if (Samples.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("No packets of type %d in %s"), PacketType, *CapturePath);
+		return false;
+	}
+
+	FPacketDictionary Dictionary(static_cast<uint16>(DictionaryId), PacketType, FPacketDictionaryTrainer::Train(Samples, DictionarySize));
+	return Dictionary.SaveToFile(OutputPath);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "PacketCompression.generated.h"
+
+// Byte-oriented LZ77 codec whose history is primed with a trained dictionary, so even a 20 byte packet can
+// be expressed as references into layouts and ids seen before. Sequences use an LZ4-style token: literal
+// count and match length nibbles with 255-run extensions, then the literals, then a 16 bit distance back
+// into dictionary-plus-output.
+class CLIENT_API FPacketDictionary
+{
+public:
+	static constexpr int32 MaxContentSize = 32 * 1024;
+	static constexpr int32 MinMatch = 4;
+
+	FPacketDictionary(uint16 InId, uint8 InPacketType, TArray<uint8>&& InContent);
+
+	uint16 GetId() const { return Id; }
+	uint8 GetPacketType() const { return PacketType; }
+	const TArray<uint8>& GetContent() const { return Content; }
+
+	static int32 GetMaxCompressedSize(int32 RawSize) { return RawSize + RawSize / 255 + 16; }
+
+	// Dest must hold GetMaxCompressedSize(Source.Num()) bytes. Returns the compressed size.
+	int32 Compress(TArrayView<const uint8> Source, uint8* Dest) const;
+
+	// Dest must hold exactly RawSize bytes. Returns false on malformed input.
+	bool Decompress(TArrayView<const uint8> Source, uint8* Dest, int32 RawSize) const;
+
+	bool SaveToFile(const FString& FilePath) const;
+	static TSharedPtr<FPacketDictionary> LoadFromFile(const FString& FilePath);
+
+private:
+	static constexpr int32 HashBits = 12;
+	static constexpr int32 MaxChainDepth = 16;
+
+	uint16 Id;
+	uint8 PacketType;
+	TArray<uint8> Content;
+	TArray<int32> HashHeads;
+	TArray<int32> HashChain;
+};
+
+// Builds a dictionary from sample payloads by repeatedly taking the segment whose d-mers are most frequent
+// across all samples and not yet covered by earlier picks. The best segments end up at the back of the
+// dictionary, closest to the data being compressed.
+class CLIENT_API FPacketDictionaryTrainer
+{
+public:
+	static constexpr int32 DmerSize = 6;
+	static constexpr int32 SegmentSize = 48;
+
+	static TArray<uint8> Train(TArrayView<const TArrayView<const uint8>> Samples, int32 DictionarySize);
+};
+
+UCLASS(MinimalAPI)
+class UPacketCompressionFunctionLibrary final : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	// Trains on the payloads of every captured frame of PacketType. Encrypted frames are decrypted with Key,
+	// or skipped when no key is given.
+	UFUNCTION(BlueprintCallable, Category = "PacketCompression")
+	static bool TrainDictionaryFromCapture(const FString& CapturePath, uint8 PacketType, int32 DictionaryId, const FString& OutputPath, int32 DictionarySize = 16384, const FString& Key = TEXT(""));
+};
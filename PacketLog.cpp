@@ -0,0 +1,157 @@
+#include "PacketLog.h"
+#include "Websocket.h"
+#include "Misc/ScopeLock.h"
+
+DEFINE_LOG_CATEGORY(LogBytePackets);
+
+struct FByteTextTables
+{
+	TCHAR LowerHex[256][2];
+	TCHAR UpperHex[256][2];
+	TCHAR Decimal[256][3];
+	uint8 DecimalLength[256];
+
+	FByteTextTables()
+	{
+		static const TCHAR LowerDigits[] = TEXT("0123456789abcdef");
+		static const TCHAR UpperDigits[] = TEXT("0123456789ABCDEF");
+
+		for (int32 Byte = 0; Byte < 256; ++Byte)
+		{
+			LowerHex[Byte][0] = LowerDigits[Byte >> 4];
+			LowerHex[Byte][1] = LowerDigits[Byte & 0xF];
+			UpperHex[Byte][0] = UpperDigits[Byte >> 4];
+			UpperHex[Byte][1] = UpperDigits[Byte & 0xF];
+
+			int32 Length = 0;
+
+			if (Byte >= 100)
+				Decimal[Byte][Length++] = TEXT('0') + Byte / 100;
+
+			if (Byte >= 10)
+				Decimal[Byte][Length++] = TEXT('0') + (Byte / 10) % 10;
+
+			Decimal[Byte][Length++] = TEXT('0') + Byte % 10;
+			DecimalLength[Byte] = static_cast<uint8>(Length);
+		}
+	}
+
+	static const FByteTextTables& Get()
+	{
+		static const FByteTextTables Tables;
+		return Tables;
+	}
+};
+
+void FPacketLog::AppendHex(FString& Out, TArrayView<const uint8> Bytes, bool bUpperSpaced)
+{
+	const FByteTextTables& Tables = FByteTextTables::Get();
+	TArray<TCHAR>& Chars = Out.GetCharArray();
+
+	const int32 Start = Out.Len();
+	const int32 CharsPerByte = bUpperSpaced ? 3 : 2;
+
+	Chars.SetNumUninitialized(Start + Bytes.Num() * CharsPerByte + 1);
+	TCHAR* Dest = Chars.GetData() + Start;
+
+	for (uint8 Byte : Bytes)
+	{
+		const TCHAR* Pair = bUpperSpaced ? Tables.UpperHex[Byte] : Tables.LowerHex[Byte];
+		*Dest++ = Pair[0];
+		*Dest++ = Pair[1];
+
+		if (bUpperSpaced)
+			*Dest++ = TEXT(' ');
+	}
+
+	*Dest = TEXT('\0');
+}
+
+void FPacketLog::AppendDecimalList(FString& Out, TArrayView<const uint8> Bytes)
+{
+	const FByteTextTables& Tables = FByteTextTables::Get();
+	TArray<TCHAR>& Chars = Out.GetCharArray();
+
+	const int32 Start = Out.Len();
+	int32 Length = Bytes.Num() > 0 ? (Bytes.Num() - 1) * 2 : 0;
+
+	for (uint8 Byte : Bytes)
+		Length += Tables.DecimalLength[Byte];
+
+	Chars.SetNumUninitialized(Start + Length + 1);
+	TCHAR* Dest = Chars.GetData() + Start;
+
+	for (int32 i = 0; i < Bytes.Num(); ++i)
+	{
+		if (i > 0)
+		{
+			*Dest++ = TEXT(',');
+			*Dest++ = TEXT(' ');
+		}
+
+		const uint8 Byte = Bytes[i];
+
+		for (int32 Digit = 0; Digit < Tables.DecimalLength[Byte]; ++Digit)
+			*Dest++ = Tables.Decimal[Byte][Digit];
+	}
+
+	*Dest = TEXT('\0');
+}
+
+void FPacketLog::LogPacket(ETrafficDirection Direction, uint8 PacketType, TArrayView<const uint8> Bytes)
+{
+	static thread_local FString Scratch;
+
+	Scratch.Reset();
+	AppendHex(Scratch, Bytes, true);
+
+	UE_LOG(LogBytePackets, Verbose, TEXT("%s packet %d (%d bytes): %s"), Direction == ETrafficDirection::Inbound ? TEXT("Recv") : TEXT("Send"), PacketType, Bytes.Num(), *Scratch);
+}
+
+FPacketJournal::FPacketJournal(int32 EntriesPerDirection)
+{
+	for (FRing& Ring : Rings)
+		Ring.Entries.SetNum(FMath::Max(1, EntriesPerDirection));
+}
+
+void FPacketJournal::Record(ETrafficDirection Direction, uint8 PacketType, TArrayView<const uint8> Bytes)
+{
+	const int64 Now = UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds();
+
+	FScopeLock ScopeLock(&Lock);
+	FRing& Ring = Rings[static_cast<int32>(Direction)];
+	FEntry& Entry = Ring.Entries[Ring.Next];
+
+	Entry.TimestampMicros = Now;
+	Entry.Size = Bytes.Num();
+	Entry.PacketType = PacketType;
+	FMemory::Memcpy(Entry.Bytes, Bytes.GetData(), FMath::Min(Bytes.Num(), MaxCapturedBytes));
+
+	Ring.Next = (Ring.Next + 1) % Ring.Entries.Num();
+	Ring.Count = FMath::Min(Ring.Count + 1, Ring.Entries.Num());
+}
+
+void FPacketJournal::Dump(const TCHAR* Reason) const
+{
+	FScopeLock ScopeLock(&Lock);
+	FString Line;
+
+	UE_LOG(LogBytePackets, Warning, TEXT("Packet journal dump: %s"), Reason);
+
+	for (int32 DirectionIndex = 0; DirectionIndex < 2; ++DirectionIndex)
+	{
+		const FRing& Ring = Rings[DirectionIndex];
+		const TCHAR* DirectionName = DirectionIndex == static_cast<int32>(ETrafficDirection::Inbound) ? TEXT("Recv") : TEXT("Send");
+
+		for (int32 i = 0; i < Ring.Count; ++i)
+		{
+			const int32 Index = (Ring.Next - Ring.Count + i + Ring.Entries.Num()) % Ring.Entries.Num();
+			const FEntry& Entry = Ring.Entries[Index];
+
+			Line.Reset();
+			FPacketLog::AppendHex(Line, TArrayView<const uint8>(Entry.Bytes, FMath::Min(Entry.Size, MaxCapturedBytes)), true);
+
+			UE_LOG(LogBytePackets, Warning, TEXT("  %s t=%lld packet %d (%d bytes): %s%s"), DirectionName, Entry.TimestampMicros, Entry.PacketType, Entry.Size, *Line, Entry.Size > MaxCapturedBytes ? TEXT("...") : TEXT(""));
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "TrafficCapture.h"
+
+// Packet contents are logged at Verbose, which is compiled in but off by default; raise it with
+// "log LogBytePackets Verbose". While it is off, packet logging costs a single verbosity check.
+CLIENT_API DECLARE_LOG_CATEGORY_EXTERN(LogBytePackets, Log, All);
+
+class CLIENT_API FPacketLog
+{
+public:
+	static FORCEINLINE bool IsEnabled()
+	{
+		return UE_LOG_ACTIVE(LogBytePackets, Verbose);
+	}
+
+	// "0a1bff" by default, "0A 1B FF " when bUpperSpaced.
+	static void AppendHex(FString& Out, TArrayView<const uint8> Bytes, bool bUpperSpaced = false);
+
+	// "10, 27, 255".
+	static void AppendDecimalList(FString& Out, TArrayView<const uint8> Bytes);
+
+	static void LogPacket(ETrafficDirection Direction, uint8 PacketType, TArrayView<const uint8> Bytes);
+};
+
+// Fixed-size ring of the last packets in each direction, kept so they can be dumped when something fails.
+class CLIENT_API FPacketJournal
+{
+public:
+	static constexpr int32 MaxCapturedBytes = 256;
+
+	explicit FPacketJournal(int32 EntriesPerDirection = 64);
+
+	void Record(ETrafficDirection Direction, uint8 PacketType, TArrayView<const uint8> Bytes);
+	void Dump(const TCHAR* Reason) const;
+
+private:
+	struct FEntry
+	{
+		int64 TimestampMicros = 0;
+		int32 Size = 0;
+		uint8 PacketType = 0;
+		uint8 Bytes[MaxCapturedBytes];
+	};
+
+	struct FRing
+	{
+		TArray<FEntry> Entries;
+		int32 Next = 0;
+		int32 Count = 0;
+	};
+
+	mutable FCriticalSection Lock;
+	FRing Rings[2];
+};
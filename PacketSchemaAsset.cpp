@@ -0,0 +1,56 @@
+#include "PacketSchemaAsset.h"
+
+void UPacketSchemaAsset::CompileSchema()
+{
+	Schema.Fields.Reset(Fields.Num());
+
+	for (const FPacketSchemaFieldDefinition& Definition : Fields)
+	{
+		FPacketSchemaField& Field = Schema.Fields.AddDefaulted_GetRef();
+		Field.Key = Definition.Key;
+		Field.ValueType = Definition.ValueType;
+	}
+
+	Schema.ComputeLayout();
+	bSchemaCompiled = true;
+}
+
+const FPacketSchema& UPacketSchemaAsset::GetSchema() const
+{
+	if (!bSchemaCompiled)
+		const_cast<UPacketSchemaAsset*>(this)->CompileSchema();
+
+	return Schema;
+}
+
+bool UPacketSchemaAsset::CanRead(UByteBuffer* Buffer) const
+{
+	const FPacketSchema& Compiled = GetSchema();
+
+	if (!Buffer || Buffer->Remaining() < Compiled.MinSize)
+		return false;
+
+	if (Compiled.bFixedSize)
+		return true;
+
+	const TArrayView<const uint8> Record = Buffer->BeginRead(Buffer->Remaining());
+
+	TArray<int32, TInlineAllocator<32>> FieldOffsets;
+	FieldOffsets.SetNumUninitialized(Compiled.Fields.Num());
+
+	return Compiled.FindFieldOffsets(Record.GetData(), Record.Num(), FieldOffsets.GetData()) != INDEX_NONE;
+}
+
+void UPacketSchemaAsset::PostLoad()
+{
+	Super::PostLoad();
+	CompileSchema();
+}
+
+#if WITH_EDITOR
+void UPacketSchemaAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	CompileSchema();
+}
+#endif
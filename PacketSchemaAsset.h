@@ -0,0 +1,50 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ByteBuffer.h"
+#include "PacketSchemaAsset.generated.h"
+
+USTRUCT(BlueprintType)
+struct FPacketSchemaFieldDefinition
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "ByteBuffer")
+	FString Key;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "ByteBuffer")
+	EDynamicValueType ValueType = EDynamicValueType::Int32;
+};
+
+// Packet layout authored as an asset, in wire order. The Read Packet and Write Packet Blueprint nodes expand
+// it into one typed UByteBuffer call per field.
+UCLASS(MinimalAPI, BlueprintType)
+class UPacketSchemaAsset final : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "ByteBuffer")
+	TArray<FPacketSchemaFieldDefinition> Fields;
+
+	// Compiled on first use. Code that edits Fields after that must call CompileSchema again.
+	const FPacketSchema& GetSchema() const;
+
+	void CompileSchema();
+
+	// True if Buffer holds a complete record at its read position; nothing is consumed.
+	UFUNCTION(BlueprintCallable, Category = "ByteBuffer")
+	bool CanRead(UByteBuffer* Buffer) const;
+
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	FPacketSchema Schema;
+	bool bSchemaCompiled = false;
+};
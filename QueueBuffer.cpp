@@ -1,5 +1,88 @@
 #include "QueueBuffer.h"
 #include "ByteBuffer.h"
+#include "BufferPool.h"
+#include "ByteStream.h"
+
+FQueueIntake::FQueueIntake()
+{
+    for (uint32 i = 0; i < Capacity; ++i)
+        Cells[i].Sequence.store(i, std::memory_order_relaxed);
+}
+
+void FQueueIntake::Push(const FQueueItem& Item)
+{
+    Bytes.fetch_add(Item.Buffer->Length(), std::memory_order_relaxed);
+
+    if (OverflowCount.load(std::memory_order_acquire) == 0 && TryPushRing(Item))
+        return;
+
+    FScopeLock ScopeLock(&OverflowLock);
+    Overflow.Add(Item);
+    OverflowCount.fetch_add(1, std::memory_order_release);
+}
+
+bool FQueueIntake::TryPushRing(const FQueueItem& Item)
+{
+    uint32 Pos = EnqueuePos.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        FCell& Cell = Cells[Pos & (Capacity - 1)];
+        const int32 Diff = static_cast<int32>(Cell.Sequence.load(std::memory_order_acquire) - Pos);
+
+        if (Diff == 0)
+        {
+            if (EnqueuePos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+            {
+                Cell.Item = Item;
+                Cell.Sequence.store(Pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (Diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            Pos = EnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool FQueueIntake::Pop(FQueueItem& OutItem)
+{
+    FCell& Cell = Cells[DequeuePos & (Capacity - 1)];
+
+    if (static_cast<int32>(Cell.Sequence.load(std::memory_order_acquire) - (DequeuePos + 1)) == 0)
+    {
+        OutItem = Cell.Item;
+        Cell.Sequence.store(DequeuePos + Capacity, std::memory_order_release);
+        ++DequeuePos;
+    }
+    // The overflow list only holds items pushed after the ring filled up, so it is read once every claimed cell
+    // has been consumed; a claimed but unpublished head cell means the ring is not empty yet.
+    else if (DequeuePos == EnqueuePos.load(std::memory_order_acquire) && OverflowCount.load(std::memory_order_acquire) > 0)
+    {
+        FScopeLock ScopeLock(&OverflowLock);
+        OutItem = Overflow[OverflowRead++];
+
+        if (OverflowRead == Overflow.Num())
+        {
+            Overflow.Reset();
+            OverflowRead = 0;
+        }
+
+        OverflowCount.fetch_sub(1, std::memory_order_release);
+    }
+    else
+    {
+        return false;
+    }
+
+    Bytes.fetch_sub(OutItem.Buffer->Length(), std::memory_order_relaxed);
+    return true;
+}
 
 UQueueBuffer* UQueueBufferFunctionLibary::CreateInstance(UWebSocket* Socket, uint8 QueuePacketType, const FString& Key)
 {
@@ -12,31 +95,92 @@ UQueueBuffer* UQueueBufferFunctionLibary::CreateInstance(UWebSocket* Socket, uin
 }
 
 void UQueueBuffer::AddBuffer(uint8 PacketType, UByteBuffer* Buffer) {
-    if (!IsDuplicatePacket(Buffer))
+    if (!Buffer || PacketType == QueuePacketType)
+        return;
+
+    FQueueItem NewItem;
+    NewItem.PacketType = PacketType;
+    NewItem.Buffer = Buffer;
+    AddItem(NewItem);
+}
+
+void UQueueBuffer::AddStandaloneBuffer(uint8 PacketType, UByteBuffer* Buffer)
+{
+    if (!Buffer)
+        return;
+
+    FQueueItem NewItem;
+    NewItem.PacketType = PacketType;
+    NewItem.Buffer = Buffer;
+    NewItem.bStandalone = true;
+    AddItem(NewItem);
+}
+
+void UQueueBuffer::AddItem(const FQueueItem& Item)
+{
+    if (IsInGameThread())
     {
-        if (PacketType != QueuePacketType) {
-            FQueueItem NewItem;
-            NewItem.PacketType = PacketType;
-            NewItem.Buffer = Buffer;
+        DrainIntake();
+        AcceptBuffer(Item);
+        return;
+    }
 
-            Queues.Add(NewItem);
-        }
+    Item.Buffer->AddToRoot();
+    Intake.Push(Item);
+}
+
+UByteStreamWriter* UQueueBuffer::OpenStream(uint8 StreamPacketType, int32 ChunkSize)
+{
+    if (!Socket)
+        return nullptr;
+
+    UByteStreamWriter* Writer = Socket->OpenStream(StreamPacketType, ChunkSize, Key);
+    Writer->SetQueue(this);
+    return Writer;
+}
+
+void UQueueBuffer::AcceptBuffer(const FQueueItem& Item)
+{
+    if (Item.bStandalone || !IsDuplicatePacket(Item.Buffer))
+        Queues.Add(Item);
+}
+
+void UQueueBuffer::DrainIntake()
+{
+    FQueueItem Item;
+
+    while (Intake.Pop(Item))
+    {
+        Item.Buffer->RemoveFromRoot();
+        AcceptBuffer(Item);
     }
 }
 
-bool UQueueBuffer::IsDuplicatePacket(UByteBuffer* Buffer)
+bool UQueueBuffer::IsDuplicatePacket(UByteBuffer* Buffer) const
 {
-    FString BufferHash = Buffer->ToString();
+    const TArray<uint8>& Bytes = Buffer->GetBuffer();
 
     for (const auto& RecentBuffer : Queues)
     {
-        if (RecentBuffer.Buffer->ToString() == BufferHash)
+        const TArray<uint8>& RecentBytes = RecentBuffer.Buffer->GetBuffer();
+
+        if (RecentBytes.Num() == Bytes.Num() && FMemory::Memcmp(RecentBytes.GetData(), Bytes.GetData(), Bytes.Num()) == 0)
             return true;        
     }
 
     return false;
 }
 
+void UQueueBuffer::BeginDestroy()
+{
+    FQueueItem Item;
+
+    while (Intake.Pop(Item))
+        Item.Buffer->RemoveFromRoot();
+
+    Super::BeginDestroy();
+}
+
 void UQueueBuffer::CheckAndSend()
 {
     auto& Buffers = Queues;
@@ -52,44 +196,200 @@ void UQueueBuffer::CheckAndSend()
 
 void UQueueBuffer::SendBuffers()
 {
-    if (Queues.Num() == 0 || !Socket) return;
+    SendBuffers(Queues.Num());
+}
 
-    if (Queues.Num() > 1)
-    {
-        UByteBuffer* CombinedBuffer = CombineBuffers(Queues);
-        TArray<uint8> FinalBuffer = CombinedBuffer->GetBuffer();
+void UQueueBuffer::SendBuffers(int32 Count)
+{
+    if (Count <= 0 || !Socket) return;
 
-        FString HexString = UByteBuffer::ByteArrayToBinaryString(FinalBuffer);
-        Socket->SendEncryptedMessage(QueuePacketType, CombinedBuffer, Key);
-    }
-    else
+    int32 First = 0;
+
+    while (First < Count)
     {
-        FString HexString = UByteBuffer::ByteArrayToBinaryString(Queues[0].Buffer->GetBuffer());
-        Socket->SendEncryptedMessage(Queues[0].PacketType, Queues[0].Buffer, Key);
+        int32 End = First + 1;
+
+        if (!Queues[First].bStandalone)
+        {
+            while (End < Count && !Queues[End].bStandalone)
+                ++End;
+        }
+
+        if (End - First > 1)
+        {
+            UByteBuffer* CombinedBuffer = CombineBuffers(TArrayView<const FQueueItem>(Queues.GetData() + First, End - First));
+            Socket->SendEncryptedMessage(QueuePacketType, CombinedBuffer, Key);
+            CombinedBuffer->ReleaseStorage();
+        }
+        else
+        {
+            Socket->SendEncryptedMessage(Queues[First].PacketType, Queues[First].Buffer, Key);
+
+            if (Queues[First].bStandalone)
+                Queues[First].Buffer->ReleaseStorage();
+        }
+
+        First = End;
     }
 
-    Queues.Empty();
+    if (Count == Queues.Num())
+        Queues.Reset();
+    else
+        Queues.RemoveAt(0, Count);
 }
 
-UByteBuffer* UQueueBuffer::CombineBuffers(const TArray<FQueueItem>& Buffers)
+UByteBuffer* UQueueBuffer::CombineBuffers(TArrayView<const FQueueItem> Buffers)
 {    
-    UByteBuffer* CombinedBuffer = UByteBuffer::CreateEmptyByteBuffer();
-  
+    int32 TotalSize = 0;
+
     for (const auto& QueueItem : Buffers)
     {
-        TArray<uint8> Buf = QueueItem.Buffer->GetBuffer();
-        CombinedBuffer->PutByte(QueueItem.PacketType);
-        CombinedBuffer->GetBuffer().Append(Buf);
-
-        for (int32 i = 0; i < EndRepeatByte; ++i)        
-            CombinedBuffer->PutByte(EndOfPacketByte);        
+        Socket->CommitInternedStrings(QueueItem.Buffer);
+        TotalSize += 1 + QueueItem.Buffer->Length() + EndRepeatByte;
     }
 
+    UByteBuffer* CombinedBuffer = UByteBuffer::CreateByteBufferWithCapacity(TotalSize);
+  
+    for (const auto& QueueItem : Buffers)
+        Socket->AppendCombinedPacket(CombinedBuffer->GetBuffer(), QueuePacketType, QueueItem.PacketType, QueueItem.Buffer->GetBuffer());
+
     return CombinedBuffer;
 }
 
+void UQueueBuffer::AppendCombinedPacket(TArray<uint8>& Frame, uint8 PacketType, TArrayView<const uint8> Payload)
+{
+    Frame.Add(PacketType);
+    Frame.Append(Payload.GetData(), Payload.Num());
+
+    for (int32 i = 0; i < EndRepeatByte; ++i)        
+        Frame.Add(EndOfPacketByte);
+}
+
 void UQueueBuffer::Tick() {
+    if (Socket)
+        Socket->Tick();
+
+    DrainIntake();
+
     if (Queues.Num() == 0 || !Socket) return;
 
-    SendBuffers();
+    if (!bPacingEnabled)
+    {
+        SendBuffers();
+        return;
+    }
+
+    RefillTokens();
+
+    if (bAdaptivePacing)
+        AdaptRate();
+
+    int32 Bytes = 0;
+    int32 Count = CountPacedItems(Bytes);
+
+    if (Count > 0)
+    {
+        SendBuffers(Count);
+        Tokens -= Bytes;
+    }
+}
+
+void UQueueBuffer::SetPacing(int32 TargetBytesPerSecond, int32 InBurstBytes, bool bAdaptive)
+{
+    bPacingEnabled = TargetBytesPerSecond > 0;
+    bAdaptivePacing = bAdaptive;
+    MaxBytesPerSecond = TargetBytesPerSecond;
+    BytesPerSecond = TargetBytesPerSecond;
+    BurstBytes = FMath::Max(InBurstBytes, 1);
+    Tokens = BurstBytes;
+    LastRefillMicros = UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds();
+    LastAdaptMicros = LastRefillMicros;
+}
+
+void UQueueBuffer::DisablePacing()
+{
+    bPacingEnabled = false;
+}
+
+void UQueueBuffer::WarmUp(int32 PacketsPerTick, int32 AveragePacketSize)
+{
+    PacketsPerTick = FMath::Max(PacketsPerTick, 1);
+    AveragePacketSize = FMath::Max(AveragePacketSize, 1);
+
+    Queues.Reserve(PacketsPerTick);
+
+    const int64 FrameSize = static_cast<int64>(PacketsPerTick) * (1 + AveragePacketSize + EndRepeatByte);
+    FByteBufferPool::Get().Prewarm(static_cast<int32>(FMath::Min<int64>(FrameSize, FByteBufferPool::MaxBlockSize)), 2);
+}
+
+int32 UQueueBuffer::GetPacingRate() const
+{
+    return bPacingEnabled ? static_cast<int32>(BytesPerSecond) : 0;
+}
+
+int32 UQueueBuffer::GetQueuedBytes() const
+{
+    int32 TotalSize = 0;
+
+    for (const auto& QueueItem : Queues)
+        TotalSize += QueueItem.Buffer->Length();
+
+    return TotalSize + Intake.GetBytes();
+}
+
+int32 UQueueBuffer::CountPacedItems(int32& OutBytes) const
+{
+    int32 Count = 0;
+    int32 Bytes = 1;
+
+    for (const auto& QueueItem : Queues)
+    {
+        const int32 ItemBytes = 1 + QueueItem.Buffer->Length() + (QueueItem.bStandalone ? 0 : EndRepeatByte);
+
+        // An item larger than the burst may still go out once the bucket is full, leaving the
+        // bucket in debt so the following ticks wait for it to be paid back.
+        const bool bFits = Bytes + ItemBytes <= Tokens || (Count == 0 && Tokens >= BurstBytes);
+
+        if (!bFits || (Count > 0 && Bytes + ItemBytes > MaxBufferSize))
+            break;
+
+        Bytes += ItemBytes;
+        ++Count;
+    }
+
+    OutBytes = Bytes;
+    return Count;
+}
+
+void UQueueBuffer::RefillTokens()
+{
+    const int64 Now = UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds();
+    const double Elapsed = (Now - LastRefillMicros) / 1000000.0;
+
+    LastRefillMicros = Now;
+    Tokens = FMath::Min(BurstBytes, Tokens + BytesPerSecond * Elapsed);
+}
+
+void UQueueBuffer::AdaptRate()
+{
+    const FNetTimingStats& Stats = Socket->GetTimingStatsRef();
+
+    if (Stats.SampleCount == 0)
+        return;
+
+    // Adjust at most once per round trip so each change can show up in the next RTT sample.
+    const int64 Now = UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds();
+    const int64 Interval = FMath::Max<int64>(100000, static_cast<int64>(Stats.SmoothedRttMs * 1000.0f));
+
+    if (Now - LastAdaptMicros < Interval)
+        return;
+
+    LastAdaptMicros = Now;
+
+    const bool bQueueing = Stats.SmoothedRttMs > Stats.MinRttMs * 1.5f + 5.0f;
+
+    if (bQueueing)
+        BytesPerSecond = FMath::Max(MaxBytesPerSecond * 0.1, BytesPerSecond * 0.85);
+    else
+        BytesPerSecond = FMath::Min(MaxBytesPerSecond, BytesPerSecond + MaxBytesPerSecond * 0.05);
 }
\ No newline at end of file
@@ -7,6 +7,8 @@
 #include "ByteBuffer.h"
 #include "Websocket.h"
 #include "Modules/ModuleManager.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
 
 #include "QueueBuffer.generated.h"
 
@@ -20,6 +22,48 @@ struct FQueueItem
 
 	UPROPERTY(BlueprintReadWrite)
 	UByteBuffer* Buffer;
+
+	// Sent as a frame of its own instead of being combined, for payloads that may contain the end-of-packet marker.
+	UPROPERTY(BlueprintReadWrite)
+	bool bStandalone = false;
+};
+
+// Hands buffers from other threads to the game thread. Producers claim a cell of a fixed ring with one
+// compare-exchange and never allocate; only while the ring is full do they fall back to a locked overflow
+// list, which the consumer drains after the ring so items from one producer stay in order.
+class FQueueIntake
+{
+public:
+	static constexpr uint32 Capacity = 1024;
+
+	FQueueIntake();
+
+	void Push(const FQueueItem& Item);
+
+	// Single consumer.
+	bool Pop(FQueueItem& OutItem);
+
+	int32 GetBytes() const { return Bytes.load(std::memory_order_relaxed); }
+
+private:
+	struct FCell
+	{
+		std::atomic<uint32> Sequence { 0 };
+		FQueueItem Item;
+	};
+
+	bool TryPushRing(const FQueueItem& Item);
+
+	FCell Cells[Capacity];
+	std::atomic<uint32> EnqueuePos { 0 };
+	uint32 DequeuePos = 0;
+
+	FCriticalSection OverflowLock;
+	TArray<FQueueItem> Overflow;
+	int32 OverflowRead = 0;
+	std::atomic<int32> OverflowCount { 0 };
+
+	std::atomic<int32> Bytes { 0 };
 };
 
 UCLASS(MinimalAPI, BlueprintType)
@@ -27,28 +71,86 @@ class UQueueBuffer final : public UObject
 {
 	GENERATED_BODY()
 
-private:
-	TArray<FQueueItem> Queues;
-	
+public:
 	static const int32 MaxBufferSize = 512 * 1024;
 	static const uint8 EndOfPacketByte = 0xFE;
 	static const int32 EndRepeatByte = 4;
 
-	bool IsDuplicatePacket(UByteBuffer* Buffer);
+	// Appends one sub-packet in the combined-frame layout: type byte, payload, end-of-packet marker.
+	static void AppendCombinedPacket(TArray<uint8>& Frame, uint8 PacketType, TArrayView<const uint8> Payload);
+
+private:
+	UPROPERTY()
+	TArray<FQueueItem> Queues;
+
+	// Items added off the game thread; rooted until Tick moves them into Queues.
+	FQueueIntake Intake;
+
+	bool bPacingEnabled = false;
+	bool bAdaptivePacing = false;
+	double MaxBytesPerSecond = 0.0;
+	double BytesPerSecond = 0.0;
+	double BurstBytes = 0.0;
+	double Tokens = 0.0;
+	int64 LastRefillMicros = 0;
+	int64 LastAdaptMicros = 0;
+
+	bool IsDuplicatePacket(UByteBuffer* Buffer) const;
+	void AddItem(const FQueueItem& Item);
+	void AcceptBuffer(const FQueueItem& Item);
+	void DrainIntake();
 	void CheckAndSend();
 	void SendBuffers();
-	UByteBuffer* CombineBuffers(const TArray<FQueueItem>& Buffers);
+	void SendBuffers(int32 Count);
+	UByteBuffer* CombineBuffers(TArrayView<const FQueueItem> Buffers);
+	// Only looks at Queues; Tick drains the intake first.
+	int32 CountPacedItems(int32& OutBytes) const;
+	void RefillTokens();
+	void AdaptRate();
 
 public:
 	UWebSocket* Socket;
 	uint8 QueuePacketType;
 	FString Key;
 
+	// Safe to call from any thread. Off the game thread the buffer is handed over through FQueueIntake
+	// and must not be modified afterwards; it joins the send queue on the next Tick.
 	UFUNCTION(BlueprintCallable, Category = "QueueBuffer")
 	void AddBuffer(uint8 PacketType, UByteBuffer* Buffer);
 
+	// Queued and paced like AddBuffer, but always sent as its own frame and never checked for duplicates.
+	// The queue releases the buffer's storage once it is sent.
+	UFUNCTION(BlueprintCallable, Category = "QueueBuffer")
+	void AddStandaloneBuffer(uint8 PacketType, UByteBuffer* Buffer);
+
+	// Opens a stream on the socket whose chunks are queued here as standalone buffers, so they are paced
+	// and stay in order with the packets around them.
+	UFUNCTION(BlueprintCallable, Category = "QueueBuffer")
+	UByteStreamWriter* OpenStream(uint8 StreamPacketType, int32 ChunkSize = 16384);
+
 	UFUNCTION(BlueprintCallable, Category = "QueueBuffer")
 	void Tick();
+
+	// Token bucket: Tick only sends what the bucket covers and keeps the rest queued in order. With
+	// bAdaptive the rate backs off while the socket's smoothed RTT shows queueing and recovers otherwise.
+	UFUNCTION(BlueprintCallable, Category = "QueueBuffer")
+	void SetPacing(int32 TargetBytesPerSecond, int32 InBurstBytes, bool bAdaptive = false);
+
+	UFUNCTION(BlueprintCallable, Category = "QueueBuffer")
+	void DisablePacing();
+
+	UFUNCTION(BlueprintPure, Category = "QueueBuffer")
+	int32 GetPacingRate() const;
+
+	// Includes buffers still waiting in the intake from other threads.
+	UFUNCTION(BlueprintPure, Category = "QueueBuffer")
+	int32 GetQueuedBytes() const;
+
+	// Pre-sizes the queue and pools the combined-frame storage for a tick carrying PacketsPerTick packets.
+	UFUNCTION(BlueprintCallable, Category = "QueueBuffer")
+	void WarmUp(int32 PacketsPerTick, int32 AveragePacketSize);
+
+	virtual void BeginDestroy() override;
 };
 
 UCLASS(MinimalAPI)
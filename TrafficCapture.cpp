@@ -0,0 +1,245 @@
+#include "TrafficCapture.h"
+#include "Websocket.h"
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+
+FTrafficCaptureWriter::~FTrafficCaptureWriter()
+{
+	Close();
+}
+
+bool FTrafficCaptureWriter::Open(const FString& FilePath)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath));
+
+	if (!File)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Unable to open capture file %s"), *FilePath);
+		return false;
+	}
+
+	StartMicros = UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds();
+	Pending.Reset();
+	Pending.Reserve(FlushThreshold * 2);
+
+	FTrafficCaptureFileHeader Header;
+	Header.StartTimeTicks = FDateTime::UtcNow().GetTicks();
+	Pending.Append(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+
+	return true;
+}
+
+void FTrafficCaptureWriter::Close()
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (File)
+	{
+		FlushPending();
+		File->Flush();
+		File.Reset();
+	}
+}
+
+bool FTrafficCaptureWriter::IsOpen() const
+{
+	return File.IsValid();
+}
+
+void FTrafficCaptureWriter::Record(ETrafficDirection Direction, uint8 PacketType, const uint8* Data, int32 Size, bool bEncrypted)
+{
+	FScopeLock ScopeLock(&Lock);
+
+	if (!File || Size < 0)
+		return;
+
+	FTrafficCaptureRecordHeader Header;
+	Header.TimestampMicros = static_cast<uint64>(UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds() - StartMicros);
+	Header.Size = static_cast<uint32>(Size);
+	Header.Direction = static_cast<uint8>(Direction);
+	Header.PacketType = PacketType;
+	Header.Flags = bEncrypted ? FTrafficCaptureRecordHeader::EncryptedFlag : 0;
+
+	const int32 Padding = Align(Size, 8) - Size;
+
+	Pending.Append(reinterpret_cast<const uint8*>(&Header), sizeof(Header));
+	Pending.Append(Data, Size);
+	Pending.AddZeroed(Padding);
+
+	if (Pending.Num() >= FlushThreshold)
+		FlushPending();
+}
+
+void FTrafficCaptureWriter::FlushPending()
+{
+	if (Pending.Num() > 0)
+	{
+		File->Write(Pending.GetData(), Pending.Num());
+		Pending.Reset();
+	}
+}
+
+FTrafficCaptureReader::~FTrafficCaptureReader()
+{
+	Close();
+}
+
+bool FTrafficCaptureReader::Open(const FString& FilePath)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	MappedFile.Reset(PlatformFile.OpenMapped(*FilePath));
+
+	if (MappedFile && MappedFile->GetFileSize() > 0)
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+
+	if (MappedRegion)
+		return IndexFrames(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+
+	MappedFile.Reset();
+
+	if (!FFileHelper::LoadFileToArray(FileData, *FilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Unable to read capture file %s"), *FilePath);
+		return false;
+	}
+
+	return IndexFrames(FileData.GetData(), FileData.Num());
+}
+
+void FTrafficCaptureReader::Close()
+{
+	Frames.Reset();
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	FileData.Empty();
+	StartTimeTicks = 0;
+}
+
+bool FTrafficCaptureReader::IndexFrames(const uint8* Data, int64 Size)
+{
+	FTrafficCaptureFileHeader FileHeader;
+
+	if (Size < static_cast<int64>(sizeof(FileHeader)))
+		return false;
+
+	FMemory::Memcpy(&FileHeader, Data, sizeof(FileHeader));
+
+	if (FileHeader.Magic != FTrafficCaptureFileHeader::CaptureMagic || FileHeader.Version != FTrafficCaptureFileHeader::CaptureVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Unsupported capture file: Magic=%08x, Version=%d"), FileHeader.Magic, FileHeader.Version);
+		return false;
+	}
+
+	StartTimeTicks = FileHeader.StartTimeTicks;
+
+	int64 Offset = FileHeader.HeaderSize;
+
+	while (Offset + static_cast<int64>(sizeof(FTrafficCaptureRecordHeader)) <= Size)
+	{
+		FTrafficCaptureRecordHeader Header;
+		FMemory::Memcpy(&Header, Data + Offset, sizeof(Header));
+		Offset += sizeof(Header);
+
+		// A capture cut short by a crash ends in a partial record; keep everything before it.
+		if (Offset + Header.Size > Size)
+			break;
+
+		FTrafficCaptureFrame& Frame = Frames.AddDefaulted_GetRef();
+		Frame.TimestampMicros = Header.TimestampMicros;
+		Frame.Direction = static_cast<ETrafficDirection>(Header.Direction);
+		Frame.PacketType = Header.PacketType;
+		Frame.bEncrypted = (Header.Flags & FTrafficCaptureRecordHeader::EncryptedFlag) != 0;
+		Frame.Data = TArrayView<const uint8>(Data + Offset, static_cast<int32>(Header.Size));
+
+		Offset += Align(static_cast<int64>(Header.Size), 8);
+	}
+
+	return true;
+}
+
+bool UTrafficReplayer::Open(const FString& FilePath)
+{
+	Reader = MakeShared<FTrafficCaptureReader>();
+	Restart();
+	return Reader->Open(FilePath);
+}
+
+void UTrafficReplayer::Restart()
+{
+	NextFrame = 0;
+	bStarted = false;
+}
+
+int32 UTrafficReplayer::Tick()
+{
+	if (!Reader || IsFinished())
+		return 0;
+
+	const int64 Now = UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds();
+
+	if (!bStarted)
+	{
+		StartMicros = Now;
+		bStarted = true;
+	}
+
+	if (PlaybackRate <= 0.0f)
+		return ReplayAll();
+
+	return ReplayUntil(static_cast<uint64>((Now - StartMicros) * static_cast<double>(PlaybackRate)));
+}
+
+int32 UTrafficReplayer::ReplayAll()
+{
+	return ReplayUntil(MAX_uint64);
+}
+
+int32 UTrafficReplayer::ReplayUntil(uint64 CaptureTimeMicros)
+{
+	if (!Reader || !Socket)
+		return 0;
+
+	const TArray<FTrafficCaptureFrame>& Frames = Reader->GetFrames();
+	int32 Replayed = 0;
+
+	while (NextFrame < Frames.Num() && Frames[NextFrame].TimestampMicros <= CaptureTimeMicros)
+	{
+		const FTrafficCaptureFrame& Frame = Frames[NextFrame++];
+
+		if (Frame.Direction == ETrafficDirection::Inbound)
+		{
+			Socket->InjectBinaryMessage(Frame.Data.GetData(), Frame.Data.Num());
+			++Replayed;
+		}
+	}
+
+	return Replayed;
+}
+
+bool UTrafficReplayer::IsFinished() const
+{
+	return !Reader || NextFrame >= Reader->GetFrames().Num();
+}
+
+int32 UTrafficReplayer::GetFrameCount() const
+{
+	return Reader ? Reader->GetFrames().Num() : 0;
+}
+
+UTrafficReplayer* UTrafficCaptureFunctionLibrary::CreateReplayer(UWebSocket* Socket, const FString& FilePath)
+{
+	UTrafficReplayer* Replayer = NewObject<UTrafficReplayer>();
+	Replayer->Socket = Socket;
+
+	if (!Replayer->Open(FilePath))
+		return nullptr;
+
+	return Replayer;
+}
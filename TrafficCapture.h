@@ -0,0 +1,149 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "HAL/CriticalSection.h"
+
+#include "TrafficCapture.generated.h"
+
+class IFileHandle;
+class IMappedFileHandle;
+class IMappedFileRegion;
+class UWebSocket;
+
+UENUM(BlueprintType)
+enum class ETrafficDirection : uint8
+{
+	Inbound,
+	Outbound
+};
+
+// On-disk layout, little endian. The file is a FTrafficCaptureFileHeader followed by records, each a
+// FTrafficCaptureRecordHeader plus payload padded to 8 bytes, so a mapped file can be walked in place.
+struct FTrafficCaptureFileHeader
+{
+	static constexpr uint32 CaptureMagic = 0x43424255; // "UBBC"
+	static constexpr uint16 CaptureVersion = 1;
+
+	uint32 Magic = CaptureMagic;
+	uint16 Version = CaptureVersion;
+	uint16 HeaderSize = sizeof(FTrafficCaptureFileHeader);
+	int64 StartTimeTicks = 0;
+};
+
+// PacketType is always the plaintext packet type. The payload is stored as it went over the wire, so it is
+// ciphertext when EncryptedFlag is set; captures written before the flag existed have it clear. Outbound
+// compressed frames are the exception: they are stored as the uncompressed frame they replaced.
+struct FTrafficCaptureRecordHeader
+{
+	static constexpr uint16 EncryptedFlag = 1;
+
+	uint64 TimestampMicros = 0;
+	uint32 Size = 0;
+	uint8 Direction = 0;
+	uint8 PacketType = 0;
+	uint16 Flags = 0;
+};
+
+static_assert(sizeof(FTrafficCaptureFileHeader) == 16, "Capture file header layout changed");
+static_assert(sizeof(FTrafficCaptureRecordHeader) == 16, "Capture record header layout changed");
+
+struct FTrafficCaptureFrame
+{
+	uint64 TimestampMicros = 0;
+	ETrafficDirection Direction = ETrafficDirection::Inbound;
+	uint8 PacketType = 0;
+	bool bEncrypted = false;
+	TArrayView<const uint8> Data;
+};
+
+class FTrafficCaptureWriter
+{
+public:
+	~FTrafficCaptureWriter();
+
+	bool Open(const FString& FilePath);
+	void Close();
+	bool IsOpen() const;
+
+	void Record(ETrafficDirection Direction, uint8 PacketType, const uint8* Data, int32 Size, bool bEncrypted = false);
+
+private:
+	static constexpr int32 FlushThreshold = 64 * 1024;
+
+	void FlushPending();
+
+	FCriticalSection Lock;
+	TUniquePtr<IFileHandle> File;
+	TArray<uint8> Pending;
+	int64 StartMicros = 0;
+};
+
+class FTrafficCaptureReader
+{
+public:
+	~FTrafficCaptureReader();
+
+	bool Open(const FString& FilePath);
+	void Close();
+
+	const TArray<FTrafficCaptureFrame>& GetFrames() const { return Frames; }
+	int64 GetStartTimeTicks() const { return StartTimeTicks; }
+
+private:
+	bool IndexFrames(const uint8* Data, int64 Size);
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> FileData;
+	TArray<FTrafficCaptureFrame> Frames;
+	int64 StartTimeTicks = 0;
+};
+
+UCLASS(BlueprintType)
+class CLIENT_API UTrafficReplayer : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "TrafficCapture")
+	float PlaybackRate = 1.0f;
+
+	UWebSocket* Socket;
+
+	bool Open(const FString& FilePath);
+
+	UFUNCTION(BlueprintCallable, Category = "TrafficCapture")
+	int32 Tick();
+
+	UFUNCTION(BlueprintCallable, Category = "TrafficCapture")
+	int32 ReplayAll();
+
+	UFUNCTION(BlueprintCallable, Category = "TrafficCapture")
+	void Restart();
+
+	UFUNCTION(BlueprintPure, Category = "TrafficCapture")
+	bool IsFinished() const;
+
+	UFUNCTION(BlueprintPure, Category = "TrafficCapture")
+	int32 GetFrameCount() const;
+
+private:
+	int32 ReplayUntil(uint64 CaptureTimeMicros);
+
+	TSharedPtr<FTrafficCaptureReader> Reader;
+	int32 NextFrame = 0;
+	int64 StartMicros = 0;
+	bool bStarted = false;
+};
+
+UCLASS(MinimalAPI)
+class UTrafficCaptureFunctionLibrary final : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintCallable, Category = "TrafficCapture")
+	static UTrafficReplayer* CreateReplayer(UWebSocket* Socket, const FString& FilePath);
+};
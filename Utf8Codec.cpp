@@ -0,0 +1,225 @@
+#include "Utf8Codec.h"
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS && PLATFORM_CPU_X86_FAMILY
+#define UTF8_SIMD_SSE2 1
+#include <emmintrin.h>
+#else
+#define UTF8_SIMD_SSE2 0
+#endif
+
+namespace
+{
+	FORCEINLINE int32 EncodeCodepoint(uint32 Codepoint, uint8* Dest)
+	{
+		if (Codepoint < 0x80)
+		{
+			Dest[0] = static_cast<uint8>(Codepoint);
+			return 1;
+		}
+
+		if (Codepoint < 0x800)
+		{
+			Dest[0] = static_cast<uint8>(0xC0 | (Codepoint >> 6));
+			Dest[1] = static_cast<uint8>(0x80 | (Codepoint & 0x3F));
+			return 2;
+		}
+
+		if (Codepoint < 0x10000)
+		{
+			Dest[0] = static_cast<uint8>(0xE0 | (Codepoint >> 12));
+			Dest[1] = static_cast<uint8>(0x80 | ((Codepoint >> 6) & 0x3F));
+			Dest[2] = static_cast<uint8>(0x80 | (Codepoint & 0x3F));
+			return 3;
+		}
+
+		Dest[0] = static_cast<uint8>(0xF0 | (Codepoint >> 18));
+		Dest[1] = static_cast<uint8>(0x80 | ((Codepoint >> 12) & 0x3F));
+		Dest[2] = static_cast<uint8>(0x80 | ((Codepoint >> 6) & 0x3F));
+		Dest[3] = static_cast<uint8>(0x80 | (Codepoint & 0x3F));
+		return 4;
+	}
+
+	FORCEINLINE int32 EncodeCodepointAsTCHAR(uint32 Codepoint, TCHAR* Dest)
+	{
+		if constexpr (sizeof(TCHAR) == 2)
+		{
+			if (Codepoint >= 0x10000)
+			{
+				Codepoint -= 0x10000;
+				Dest[0] = static_cast<TCHAR>(0xD800 | (Codepoint >> 10));
+				Dest[1] = static_cast<TCHAR>(0xDC00 | (Codepoint & 0x3FF));
+				return 2;
+			}
+		}
+
+		Dest[0] = static_cast<TCHAR>(Codepoint);
+		return 1;
+	}
+
+	FORCEINLINE bool IsContinuation(uint8 Byte)
+	{
+		return (Byte & 0xC0) == 0x80;
+	}
+
+	// Decodes one sequence starting at Source[0]; consumes a single byte when the sequence is malformed.
+	FORCEINLINE uint32 DecodeSequence(const uint8* Source, int32 Available, int32& OutConsumed)
+	{
+		const uint8 Lead = Source[0];
+		OutConsumed = 1;
+
+		if (Lead < 0xC2 || Lead > 0xF4)
+			return UNICODE_BOGUS_CHAR_CODEPOINT;
+
+		if (Lead < 0xE0)
+		{
+			if (Available < 2 || !IsContinuation(Source[1]))
+				return UNICODE_BOGUS_CHAR_CODEPOINT;
+
+			OutConsumed = 2;
+			return ((Lead & 0x1F) << 6) | (Source[1] & 0x3F);
+		}
+
+		if (Lead < 0xF0)
+		{
+			if (Available < 3 || !IsContinuation(Source[1]) || !IsContinuation(Source[2]))
+				return UNICODE_BOGUS_CHAR_CODEPOINT;
+
+			const uint32 Codepoint = ((Lead & 0x0F) << 12) | ((Source[1] & 0x3F) << 6) | (Source[2] & 0x3F);
+
+			if (Codepoint < 0x800 || (Codepoint >= 0xD800 && Codepoint <= 0xDFFF))
+				return UNICODE_BOGUS_CHAR_CODEPOINT;
+
+			OutConsumed = 3;
+			return Codepoint;
+		}
+
+		if (Available < 4 || !IsContinuation(Source[1]) || !IsContinuation(Source[2]) || !IsContinuation(Source[3]))
+			return UNICODE_BOGUS_CHAR_CODEPOINT;
+
+		const uint32 Codepoint = ((Lead & 0x07) << 18) | ((Source[1] & 0x3F) << 12) | ((Source[2] & 0x3F) << 6) | (Source[3] & 0x3F);
+
+		if (Codepoint < 0x10000 || Codepoint > 0x10FFFF)
+			return UNICODE_BOGUS_CHAR_CODEPOINT;
+
+		OutConsumed = 4;
+		return Codepoint;
+	}
+}
+
+int32 FUtf8Codec::Encode(const TCHAR* Source, int32 NumChars, uint8* Dest)
+{
+	uint8* const DestStart = Dest;
+	const TCHAR* const SourceEnd = Source + NumChars;
+
+	while (Source < SourceEnd)
+	{
+#if UTF8_SIMD_SSE2
+		if constexpr (sizeof(TCHAR) == 2)
+		{
+			const __m128i NonAsciiMask = _mm_set1_epi16(static_cast<int16>(0xFF80));
+
+			while (SourceEnd - Source >= 16)
+			{
+				const __m128i Lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source));
+				const __m128i Hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source + 8));
+				const __m128i NonAscii = _mm_and_si128(_mm_or_si128(Lo, Hi), NonAsciiMask);
+
+				if (_mm_movemask_epi8(_mm_cmpeq_epi16(NonAscii, _mm_setzero_si128())) != 0xFFFF)
+					break;
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dest), _mm_packus_epi16(Lo, Hi));
+				Source += 16;
+				Dest += 16;
+			}
+
+			if (Source == SourceEnd)
+				break;
+		}
+#endif
+
+		uint32 Char = static_cast<uint32>(*Source++);
+
+		if (Char < 0x80)
+		{
+			*Dest++ = static_cast<uint8>(Char);
+			continue;
+		}
+
+		if constexpr (sizeof(TCHAR) == 2)
+		{
+			if (Char >= 0xD800 && Char <= 0xDBFF && Source < SourceEnd && *Source >= 0xDC00 && *Source <= 0xDFFF)
+				Char = 0x10000 + ((Char - 0xD800) << 10) + (static_cast<uint32>(*Source++) - 0xDC00);
+			else if (Char >= 0xD800 && Char <= 0xDFFF)
+				Char = UNICODE_BOGUS_CHAR_CODEPOINT;
+		}
+		else if ((Char >= 0xD800 && Char <= 0xDFFF) || Char > 0x10FFFF)
+		{
+			Char = UNICODE_BOGUS_CHAR_CODEPOINT;
+		}
+
+		Dest += EncodeCodepoint(Char, Dest);
+	}
+
+	return static_cast<int32>(Dest - DestStart);
+}
+
+int32 FUtf8Codec::Decode(const uint8* Source, int32 NumBytes, TCHAR* Dest)
+{
+	TCHAR* const DestStart = Dest;
+	const uint8* const SourceEnd = Source + NumBytes;
+
+	while (Source < SourceEnd)
+	{
+#if UTF8_SIMD_SSE2
+		if constexpr (sizeof(TCHAR) == 2)
+		{
+			while (SourceEnd - Source >= 16)
+			{
+				const __m128i Bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Source));
+
+				if (_mm_movemask_epi8(Bytes) != 0)
+					break;
+
+				const __m128i Zero = _mm_setzero_si128();
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dest), _mm_unpacklo_epi8(Bytes, Zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(Dest + 8), _mm_unpackhi_epi8(Bytes, Zero));
+				Source += 16;
+				Dest += 16;
+			}
+
+			if (Source == SourceEnd)
+				break;
+		}
+#endif
+
+		if (*Source < 0x80)
+		{
+			*Dest++ = static_cast<TCHAR>(*Source++);
+			continue;
+		}
+
+		int32 Consumed = 0;
+		const uint32 Codepoint = DecodeSequence(Source, static_cast<int32>(SourceEnd - Source), Consumed);
+		Source += Consumed;
+		Dest += EncodeCodepointAsTCHAR(Codepoint, Dest);
+	}
+
+	return static_cast<int32>(Dest - DestStart);
+}
+
+void FUtf8Codec::DecodeToString(const uint8* Source, int32 NumBytes, FString& Out)
+{
+	TArray<TCHAR>& Chars = Out.GetCharArray();
+
+	if (NumBytes <= 0)
+	{
+		Chars.Reset();
+		return;
+	}
+
+	Chars.SetNumUninitialized(NumBytes + 1);
+	const int32 NumChars = Decode(Source, NumBytes, Chars.GetData());
+
+	Chars.SetNumUninitialized(NumChars + 1);
+	Chars[NumChars] = TEXT('\0');
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Direct transcoding between TCHAR storage and UTF-8 wire bytes. ASCII runs are checked and widened or
+// narrowed 16 characters at a time; only spans containing non-ASCII characters take the per-character path.
+// Unpaired surrogates and malformed UTF-8 become UNICODE_BOGUS_CHAR_CODEPOINT, as with FTCHARToUTF8/FUTF8ToTCHAR.
+class CLIENT_API FUtf8Codec
+{
+public:
+	static FORCEINLINE int32 GetMaxEncodedLength(int32 NumChars)
+	{
+		return NumChars * (sizeof(TCHAR) == 2 ? 3 : 4);
+	}
+
+	// Dest must hold GetMaxEncodedLength(NumChars) bytes. Returns the number of bytes written.
+	static int32 Encode(const TCHAR* Source, int32 NumChars, uint8* Dest);
+
+	// Dest must hold NumBytes characters. Returns the number of characters written.
+	static int32 Decode(const uint8* Source, int32 NumBytes, TCHAR* Dest);
+
+	// Replaces the contents of Out, decoding straight into its character storage.
+	static void DecodeToString(const uint8* Source, int32 NumBytes, FString& Out);
+};
@@ -2,17 +2,25 @@
 #include "IWebSocket.h"
 #include "ByteBuffer.h"
 #include "Encryption.h"
+#include "TrafficCapture.h"
+#include "LoopbackWebSocket.h"
+#include "BufferPool.h"
+#include "NetStringTable.h"
+#include "PacketLog.h"
+#include "ByteStream.h"
+#include "PacketCompression.h"
+#include "QueueBuffer.h"
+#include "FrameArena.h"
 #include "WebSocketsModule.h"
+#include "Runtime/Launch/Resources/Version.h"
 
 #define LOCTEXT_NAMESPACE "FToSWebsocketsModule"
 
 void LogByteArray(const TArray<uint8>& ByteArray)
 {
 	FString HexString;
+	FPacketLog::AppendHex(HexString, ByteArray, true);
 
-	for (uint8 Byte : ByteArray)	
-		HexString += FString::Printf(TEXT("%02X "), Byte);
-	
 	UE_LOG(LogTemp, Log, TEXT("Byte Array: %s"), *HexString);
 }
 
@@ -47,67 +55,886 @@ void UWebSocket::SendMessage(uint8 PacketType, UByteBuffer* Message)
 {
 	//LogByteArray(Message->GetBuffer());
 
-	const TArray<uint8>& OriginalData = Message->GetBuffer();
-	TArray<uint8> NewData;
+	CommitInternedStrings(Message);
 
-	NewData.Reserve(1 + OriginalData.Num());
-	NewData.Add(PacketType);
-	NewData.Append(OriginalData);
+	TArray<uint8> NewData;
+	const uint8 WirePacketType = BuildFrame(PacketType, Message->GetBuffer(), NewData);
 
 	//LogByteArray(NewData);
 
-	InternalWebSocket->Send(NewData.GetData(), NewData.Num(), true);
+	TArray<uint8> CaptureData;
+	BuildCaptureFrame(PacketType, WirePacketType, Message->GetBuffer(), FString(), CaptureData);
+
+	SendFrame(WirePacketType, NewData, false, PacketType, CaptureData);
+	FByteBufferPool::Get().Release(MoveTemp(NewData));
+	FByteBufferPool::Get().Release(MoveTemp(CaptureData));
 }
 
 void UWebSocket::SendEncryptedMessage(uint8 PacketType, UByteBuffer* Message, const FString& Key)
 {
-	const TArray<uint8>& OriginalData = Message->GetBuffer();
+	CommitInternedStrings(Message);
+
 	TArray<uint8> NewData;
+	const uint8 WirePacketType = BuildFrame(PacketType, Message->GetBuffer(), NewData);
+
+	TArray<uint8> CaptureData;
+	BuildCaptureFrame(PacketType, WirePacketType, Message->GetBuffer(), Key, CaptureData);
+
+	UEncryption::EncryptBufferInPlace(NewData, Key);
+	SendFrame(WirePacketType, NewData, !Key.IsEmpty(), PacketType, CaptureData);
+	FByteBufferPool::Get().Release(MoveTemp(NewData));
+	FByteBufferPool::Get().Release(MoveTemp(CaptureData));
+}
+
+void UWebSocket::SetInboundKey(const FString& Key)
+{
+	InboundKey = Key;
+}
+
+static int32 WriteVarUInt32(uint8* Out, uint32 Value)
+{
+	int32 Count = 0;
+
+	for (; Value >= 0x80; Value >>= 7)
+		Out[Count++] = static_cast<uint8>(Value | 0x80);
+
+	Out[Count++] = static_cast<uint8>(Value);
+	return Count;
+}
+
+static constexpr uint32 MaxDecompressedSize = 16 * 1024 * 1024;
+static constexpr int32 MaxCompressedHeaderSize = 4 + 5;
+
+static bool ReadVarUInt32(const uint8* Data, int32 Size, int32& InOutOffset, uint32& OutValue)
+{
+	OutValue = 0;
+
+	for (int32 Shift = 0; Shift < 35 && InOutOffset < Size; Shift += 7)
+	{
+		const uint8 Byte = Data[InOutOffset++];
+		OutValue |= static_cast<uint32>(Byte & 0x7F) << Shift;
+
+		if ((Byte & 0x80) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+// Drops the tail of Frame without giving capacity back, so pooled blocks keep their size class.
+static void TruncateFrame(TArray<uint8>& Frame, int32 NewNum)
+{
+#if ENGINE_MAJOR_VERSION > 5 || (ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 4)
+	Frame.SetNum(NewNum, EAllowShrinking::No);
+#else
+	Frame.SetNum(NewNum, false);
+#endif
+}
+
+// Body of a compressed frame after its wire type: dictionary id, original type, raw size, then the token stream.
+static int32 WriteCompressedBody(const FPacketDictionary& Dictionary, uint8 PacketType, TArrayView<const uint8> Payload, uint8* Out)
+{
+	ByteBufferDetail::Store<uint16>(Out, Dictionary.GetId());
+	Out[2] = PacketType;
+
+	const int32 HeaderSize = 3 + WriteVarUInt32(Out + 3, static_cast<uint32>(Payload.Num()));
+	return HeaderSize + Dictionary.Compress(Payload, Out + HeaderSize);
+}
+
+uint8 UWebSocket::BuildFrame(uint8 PacketType, TArrayView<const uint8> Payload, TArray<uint8>& OutFrame) const
+{
+	const TSharedPtr<const FPacketDictionary>* Dictionary = bCompressionEnabled && PacketType != CompressedPacketType ? SendDictionaries.Find(PacketType) : nullptr;
+
+	if (!Dictionary)
+	{
+		OutFrame = FByteBufferPool::Get().Acquire(1 + Payload.Num());
+		OutFrame.Add(PacketType);
+		OutFrame.Append(Payload.GetData(), Payload.Num());
+		return PacketType;
+	}
+
+	// Compressed frame: wire type, then the compressed body. It is built at full worst-case size and truncated,
+	// or replaced by the plain frame if it does not beat it.
+	const int32 MaxFrameSize = MaxCompressedHeaderSize + FPacketDictionary::GetMaxCompressedSize(Payload.Num());
+	OutFrame = FByteBufferPool::Get().Acquire(MaxFrameSize);
+	OutFrame.SetNumUninitialized(MaxFrameSize);
+
+	uint8* Out = OutFrame.GetData();
+	Out[0] = CompressedPacketType;
+
+	const int32 CompressedSize = 1 + WriteCompressedBody(**Dictionary, PacketType, Payload, Out + 1);
+
+	if (CompressedSize < 1 + Payload.Num())
+	{
+		TruncateFrame(OutFrame, CompressedSize);
+		return CompressedPacketType;
+	}
+
+	TruncateFrame(OutFrame, 0);
+	OutFrame.Add(PacketType);
+	OutFrame.Append(Payload.GetData(), Payload.Num());
+	return PacketType;
+}
+
+void UWebSocket::AppendCombinedPacket(TArray<uint8>& Frame, uint8 CombinedType, uint8 PacketType, TArrayView<const uint8> Payload) const
+{
+	const bool bCompress = bCompressionEnabled && bCombinedCompressionEnabled && CombinedType == CombinedPacketType && PacketType != CompressedPacketType;
+	const TSharedPtr<const FPacketDictionary>* Dictionary = bCompress ? SendDictionaries.Find(PacketType) : nullptr;
+
+	if (Dictionary)
+	{
+		// Compressed sub-packet: compressed type, body size, body, end-of-packet marker. The size lets the
+		// receiver step over the body, which may contain the marker itself.
+		const int32 Start = Frame.Num();
+		Frame.SetNumUninitialized(Start + 4 + MaxCompressedHeaderSize + FPacketDictionary::GetMaxCompressedSize(Payload.Num()));
+
+		uint8* Out = Frame.GetData() + Start;
+		Out[0] = CompressedPacketType;
+
+		const int32 BodySize = WriteCompressedBody(**Dictionary, PacketType, Payload, Out + 5);
+		ByteBufferDetail::Store<uint32>(Out + 1, static_cast<uint32>(BodySize));
+
+		if (5 + BodySize < 1 + Payload.Num())
+		{
+			TruncateFrame(Frame, Start + 5 + BodySize);
+
+			for (int32 i = 0; i < UQueueBuffer::EndRepeatByte; ++i)
+				Frame.Add(UQueueBuffer::EndOfPacketByte);
+
+			return;
+		}
+
+		TruncateFrame(Frame, Start);
+	}
+
+	UQueueBuffer::AppendCombinedPacket(Frame, PacketType, Payload);
+}
+
+bool UWebSocket::ReadCompressedHeader(const uint8* Body, int32 Size, int32& OutOffset, uint32& OutRawSize, const FPacketDictionary*& OutDictionary) const
+{
+	OutOffset = 3;
+
+	if (Size < 4 || !ReadVarUInt32(Body, Size, OutOffset, OutRawSize) || OutRawSize > MaxDecompressedSize)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Malformed compressed packet header (%d bytes)"), Size + 1);
+		return false;
+	}
+
+	// A compressed frame never wraps another one; nesting them would let a crafted frame recurse.
+	if (Body[2] == CompressedPacketType)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Compressed packet wraps another compressed packet"));
+		return false;
+	}
+
+	const uint16 DictionaryId = ByteBufferDetail::Load<uint16>(Body);
+	const TSharedPtr<const FPacketDictionary>* Dictionary = ReceiveDictionaries.Find(DictionaryId);
+
+	if (!Dictionary)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Compressed packet uses unknown dictionary %d"), DictionaryId);
+		return false;
+	}
+
+	OutDictionary = Dictionary->Get();
+	return true;
+}
+
+bool UWebSocket::DecompressFrame(const uint8* Data, int32 Size, TArray<uint8>& OutFrame) const
+{
+	int32 Offset = 0;
+	uint32 RawSize = 0;
+	const FPacketDictionary* Dictionary = nullptr;
+
+	if (!ReadCompressedHeader(Data + 1, Size - 1, Offset, RawSize, Dictionary))
+		return false;
+
+	OutFrame = FByteBufferPool::Get().Acquire(1 + RawSize);
+	OutFrame.SetNumUninitialized(1 + RawSize);
+	OutFrame[0] = Data[3];
+
+	if (!Dictionary->Decompress(TArrayView<const uint8>(Data + 1 + Offset, Size - 1 - Offset), OutFrame.GetData() + 1, static_cast<int32>(RawSize)))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Corrupt compressed packet %d (dictionary %d)"), Data[3], Dictionary->GetId());
+		return false;
+	}
+
+	return true;
+}
+
+bool UWebSocket::ExpandCombinedFrame(const uint8* Data, int32 Size, TArray<uint8>& OutFrame) const
+{
+	OutFrame = FByteBufferPool::Get().Acquire(Size);
+	OutFrame.Add(Data[0]);
+
+	int32 Offset = 1;
+	bool bExpandedAny = false;
+
+	while (Offset < Size)
+	{
+		if (Data[Offset] != CompressedPacketType)
+		{
+			// Plain sub-packets run up to and including the end-of-packet marker, the last one possibly without it.
+			int32 End = Offset;
+			int32 Run = 0;
+
+			while (End < Size && Run < UQueueBuffer::EndRepeatByte)
+				Run = Data[End++] == UQueueBuffer::EndOfPacketByte ? Run + 1 : 0;
+
+			OutFrame.Append(Data + Offset, End - Offset);
+			Offset = End;
+			continue;
+		}
+
+		const int32 BodyStart = Offset + 5;
+		const int64 BodySize = BodyStart <= Size ? static_cast<int64>(ByteBufferDetail::Load<uint32>(Data + Offset + 1)) : -1;
+
+		if (BodySize < 0 || BodyStart + BodySize + UQueueBuffer::EndRepeatByte > Size)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Malformed compressed sub-packet in combined packet %d"), Data[0]);
+			return false;
+		}
+
+		int32 HeaderSize = 0;
+		uint32 RawSize = 0;
+		const FPacketDictionary* Dictionary = nullptr;
+		const uint8* Body = Data + BodyStart;
+
+		if (!ReadCompressedHeader(Body, static_cast<int32>(BodySize), HeaderSize, RawSize, Dictionary))
+			return false;
+
+		if (OutFrame.Num() + 1 + static_cast<int64>(RawSize) > MaxDecompressedSize)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Combined packet %d expands past %u bytes"), Data[0], MaxDecompressedSize);
+			return false;
+		}
+
+		const int32 ItemStart = OutFrame.Num();
+		OutFrame.SetNumUninitialized(ItemStart + 1 + RawSize);
+		OutFrame[ItemStart] = Body[2];
+
+		if (!Dictionary->Decompress(TArrayView<const uint8>(Body + HeaderSize, static_cast<int32>(BodySize) - HeaderSize), OutFrame.GetData() + ItemStart + 1, static_cast<int32>(RawSize)))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Corrupt compressed sub-packet %d (dictionary %d)"), Body[2], Dictionary->GetId());
+			return false;
+		}
+
+		OutFrame.Append(Data + BodyStart + BodySize, UQueueBuffer::EndRepeatByte);
+		Offset = BodyStart + static_cast<int32>(BodySize) + UQueueBuffer::EndRepeatByte;
+		bExpandedAny = true;
+	}
+
+	return bExpandedAny;
+}
+
+void UWebSocket::EnablePacketCompression(uint8 InCompressedPacketType)
+{
+	bCompressionEnabled = true;
+	CompressedPacketType = InCompressedPacketType;
+}
+
+void UWebSocket::DisablePacketCompression()
+{
+	bCompressionEnabled = false;
+	bCombinedCompressionEnabled = false;
+}
+
+void UWebSocket::EnableCombinedPacketCompression(uint8 InCombinedPacketType)
+{
+	bCombinedCompressionEnabled = true;
+	CombinedPacketType = InCombinedPacketType;
+}
+
+bool UWebSocket::LoadCompressionDictionary(const FString& FilePath)
+{
+	TSharedPtr<FPacketDictionary> Dictionary = FPacketDictionary::LoadFromFile(FilePath);
+
+	if (!Dictionary)
+		return false;
+
+	AddCompressionDictionary(Dictionary);
+	return true;
+}
+
+void UWebSocket::AddCompressionDictionary(TSharedPtr<const FPacketDictionary> Dictionary)
+{
+	SendDictionaries.Add(Dictionary->GetPacketType(), Dictionary);
+	ReceiveDictionaries.Add(Dictionary->GetId(), Dictionary);
+}
+
+UByteBuffer* UWebSocket::DecompressPacket(UByteBuffer* Packet)
+{
+	if (!Packet || Packet->GetBuffer().Num() == 0 || Packet->GetBuffer()[0] != CompressedPacketType)
+		return nullptr;
+
+	TArray<uint8> Frame;
+	UByteBuffer* Result = nullptr;
+
+	if (DecompressFrame(Packet->GetBuffer().GetData(), Packet->GetBuffer().Num(), Frame))
+		Result = UByteBuffer::CreateByteBufferFromBytes(Frame.GetData(), Frame.Num());
+
+	FByteBufferPool::Get().Release(MoveTemp(Frame));
+	return Result;
+}
+
+void UWebSocket::WarmUp(const FNetWarmupProfile& Profile)
+{
+	FByteBufferPool& Pool = FByteBufferPool::Get();
+	const int32 PacketsPerFrame = FMath::Max(Profile.PacketsPerFrame, 1);
+	const int32 AveragePacketSize = FMath::Clamp(Profile.AveragePacketSize, 1, FByteBufferPool::MaxBlockSize);
+
+	Pool.Prewarm(AveragePacketSize, PacketsPerFrame);
+	Pool.Prewarm(FMath::Min(Profile.MaxPacketSize, FByteBufferPool::MaxBlockSize), 4);
+
+	if (IsInGameThread())
+		FFrameArena::GetGameThread().Allocate(static_cast<SIZE_T>(PacketsPerFrame) * AveragePacketSize);
+
+	for (const FPacketSchemaDefinition& Definition : Profile.Schemas)
+	{
+		const TSharedRef<const FPacketSchema> Schema = FPacketSchema::FindOrCompile(Definition.DataSequence);
+
+		TArray<FDynamicValue> Values;
+		Values.SetNum(Schema->Fields.Num());
+
+		for (int32 i = 0; i < Values.Num(); ++i)
+			Values[i].ValueType = Schema->Fields[i].ValueType;
+
+		UByteBuffer* Packet = UByteBuffer::CreateByteBufferWithCapacity(Schema->MinSize);
+		Packet->WriteDataWithSchema(*Schema, Values);
+
+		// The written buffer's position sits at its end, so both decodes read from fresh copies.
+		UByteBuffer* EagerPacket = UByteBuffer::CreateByteBufferFromBytes(Packet->GetBuffer().GetData(), Packet->GetBuffer().Num());
+		UByteBuffer* LazyPacket = UByteBuffer::CreateByteBufferFromBytes(Packet->GetBuffer().GetData(), Packet->GetBuffer().Num());
+		UBufferData* Data = nullptr;
+		EagerPacket->ReadDataWithSchema(*Schema, Data, Definition.PacketType);
+		LazyPacket->ReadDataLazy(Schema, Data, Definition.PacketType);
+
+		if (bCompressionEnabled && SendDictionaries.Contains(Definition.PacketType))
+		{
+			TArray<uint8> Frame;
+			BuildFrame(Definition.PacketType, Packet->GetBuffer(), Frame);
+			Pool.Release(MoveTemp(Frame));
+		}
+
+		Packet->ReleaseStorage();
+		EagerPacket->ReleaseStorage();
+		LazyPacket->ReleaseStorage();
+	}
+}
+
+bool UWebSocket::BuildCaptureFrame(uint8 PacketType, uint8 WirePacketType, TArrayView<const uint8> Payload, const FString& Key, TArray<uint8>& OutFrame) const
+{
+	if (WirePacketType == PacketType || !bCapturing.load(std::memory_order_relaxed))
+		return false;
+
+	OutFrame = FByteBufferPool::Get().Acquire(1 + Payload.Num());
+	OutFrame.Add(PacketType);
+	OutFrame.Append(Payload.GetData(), Payload.Num());
+
+	if (!Key.IsEmpty())
+		UEncryption::EncryptBufferInPlace(OutFrame, Key);
+
+	return true;
+}
+
+void UWebSocket::SendFrame(uint8 PacketType, const TArray<uint8>& Frame, bool bEncrypted, uint8 CapturePacketType, TArrayView<const uint8> CaptureFrame)
+{
+	TSharedPtr<FTrafficCaptureWriter> Writer;
+	TSharedPtr<FPacketJournal> Journal;
+
+	if (bHasDiagnostics.load(std::memory_order_acquire))
+	{
+		FScopeLock ScopeLock(&DiagnosticsLock);
+		Writer = CaptureWriter;
+		Journal = PacketJournal;
+	}
+
+	if (Writer && CaptureFrame.Num() > 0)
+		Writer->Record(ETrafficDirection::Outbound, CapturePacketType, CaptureFrame.GetData(), CaptureFrame.Num(), bEncrypted);
+	else if (Writer)
+		Writer->Record(ETrafficDirection::Outbound, PacketType, Frame.GetData(), Frame.Num(), bEncrypted);
+
+	if (Journal)
+		Journal->Record(ETrafficDirection::Outbound, PacketType, Frame);
+
+	if (FPacketLog::IsEnabled())
+		FPacketLog::LogPacket(ETrafficDirection::Outbound, PacketType, Frame);
+
+	InternalWebSocket->Send(Frame.GetData(), Frame.Num(), true);
+}
+
+bool UWebSocket::StartCapture(const FString& FilePath)
+{
+	TSharedPtr<FTrafficCaptureWriter> Writer = MakeShared<FTrafficCaptureWriter>();
+
+	if (!Writer->Open(FilePath))
+		return false;
+
+	FScopeLock ScopeLock(&DiagnosticsLock);
+	CaptureWriter = Writer;
+	bHasDiagnostics = true;
+	bCapturing = true;
+	return true;
+}
+
+void UWebSocket::StopCapture()
+{
+	FScopeLock ScopeLock(&DiagnosticsLock);
+
+	if (CaptureWriter)
+	{
+		CaptureWriter->Close();
+		CaptureWriter.Reset();
+	}
+
+	bHasDiagnostics = PacketJournal.IsValid();
+	bCapturing = false;
+}
+
+bool UWebSocket::IsCapturing() const
+{
+	return bCapturing.load(std::memory_order_relaxed);
+}
+
+void UWebSocket::EnablePacketJournal(int32 EntriesPerDirection)
+{
+	TSharedPtr<FPacketJournal> Journal = MakeShared<FPacketJournal>(EntriesPerDirection);
+	FScopeLock ScopeLock(&DiagnosticsLock);
+	PacketJournal = Journal;
+	bHasDiagnostics = true;
+}
+
+void UWebSocket::DisablePacketJournal()
+{
+	FScopeLock ScopeLock(&DiagnosticsLock);
+	PacketJournal.Reset();
+	bHasDiagnostics = CaptureWriter.IsValid();
+}
+
+void UWebSocket::DumpPacketJournal(const FString& Reason) const
+{
+	if (PacketJournal)
+		PacketJournal->Dump(*Reason);
+}
+
+void UWebSocket::EnableStringInterning(int32 Capacity)
+{
+	OutgoingStrings = MakeShared<FNetStringTable>(Capacity);
+	IncomingStrings = MakeShared<FNetStringTable>(Capacity);
+}
+
+// Each connection starts with empty tables on both peers; buffers written before a reconnect still commit
+// against the reset table, since their strings are only resolved at send time.
+void UWebSocket::ResetStringTables()
+{
+	if (OutgoingStrings)
+		OutgoingStrings->Reset();
+
+	if (IncomingStrings)
+		IncomingStrings->Reset();
+}
+
+void UWebSocket::CommitInternedStrings(UByteBuffer* Message)
+{
+	// A frame sent while disconnected is dropped by the transport, so it must not claim slots either.
+	Message->CommitInternedStrings(IsConnected() ? OutgoingStrings : TSharedPtr<FNetStringTable>());
+}
+
+void UWebSocket::DisableStringInterning()
+{
+	OutgoingStrings.Reset();
+	IncomingStrings.Reset();
+}
 
-	NewData.Reserve(1 + OriginalData.Num());
-	NewData.Add(PacketType);
-	NewData.Append(OriginalData);
+bool UWebSocket::IsStringInterningEnabled() const
+{
+	return OutgoingStrings.IsValid();
+}
+
+TSharedPtr<FNetStringTable> UWebSocket::GetOutgoingStringTable() const
+{
+	return OutgoingStrings;
+}
 
-	const TArray<uint8>& EncryptedData = UEncryption::EncryptBuffer(NewData, Key);
-	InternalWebSocket->Send(EncryptedData.GetData(), EncryptedData.Num(), true);
+TSharedPtr<FNetStringTable> UWebSocket::GetIncomingStringTable() const
+{
+	return IncomingStrings;
+}
+
+void FNetTimingStats::AddSample(int64 RttMicros, int64 ClockOffsetMicros)
+{
+	const float RttMs = RttMicros / 1000.0f;
+	const float OffsetMs = ClockOffsetMicros / 1000.0f;
+
+	LastRttMs = RttMs;
+
+	// Smoothing follows RFC 6298: SRTT gains 1/8 of each sample and the jitter 1/4 of the deviation.
+	if (SampleCount == 0)
+	{
+		SmoothedRttMs = RttMs;
+		JitterMs = RttMs / 2.0f;
+		MinRttMs = RttMs;
+		ServerClockOffsetMs = OffsetMs;
+	}
+	else
+	{
+		JitterMs += (FMath::Abs(SmoothedRttMs - RttMs) - JitterMs) * 0.25f;
+		SmoothedRttMs += (RttMs - SmoothedRttMs) * 0.125f;
+		MinRttMs = FMath::Min(MinRttMs, RttMs);
+
+		// Offsets measured over a near-minimal round trip are the least skewed by queueing, so trust them more.
+		const float OffsetGain = RttMs <= MinRttMs * 1.5f ? 0.25f : 0.0625f;
+		ServerClockOffsetMs += (OffsetMs - ServerClockOffsetMs) * OffsetGain;
+	}
+
+	++SampleCount;
+}
+
+void UWebSocket::EnablePing(float IntervalSeconds)
+{
+	bPingEnabled = true;
+	PingIntervalMicros = static_cast<int64>(FMath::Max(IntervalSeconds, 0.01f) * 1000000.0f);
+	LastPingMicros = 0;
+	TimingStats = FNetTimingStats();
+}
+
+void UWebSocket::DisablePing()
+{
+	bPingEnabled = false;
+}
+
+void UWebSocket::Tick()
+{
+	const int64 Now = UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds();
+
+	if (StreamAssemblies.Num() > 0)
+		EvictStreamAssemblies(Now);
+
+	if (!bPingEnabled || !InternalWebSocket || !InternalWebSocket->IsConnected())
+		return;
+
+	if (LastPingMicros == 0 || Now - LastPingMicros >= PingIntervalMicros)
+	{
+		LastPingMicros = Now;
+		SendPing();
+	}
+}
+
+// The leading control character keeps timing messages from colliding with application text.
+static const TCHAR* const PingPrefix = TEXT("\x01ping ");
+static const TCHAR* const PongPrefix = TEXT("\x01pong ");
+static constexpr int32 TimingPrefixLength = 6;
+
+static bool IsTimingMessage(const FString& Message)
+{
+	return Message.StartsWith(PingPrefix, ESearchCase::CaseSensitive) || Message.StartsWith(PongPrefix, ESearchCase::CaseSensitive);
+}
+
+void UWebSocket::SendPing()
+{
+	InternalWebSocket->Send(FString::Printf(TEXT("%s%lld"), PingPrefix, UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds()));
+}
+
+bool UWebSocket::HandleTimingMessage(const FString& Message)
+{
+	if (!IsTimingMessage(Message))
+		return false;
+
+	const int64 Now = UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds();
+	TArray<FString> Fields;
+	Message.Mid(TimingPrefixLength).ParseIntoArray(Fields, TEXT(" "));
+
+	if (Message.StartsWith(PingPrefix, ESearchCase::CaseSensitive))
+	{
+		if (Fields.Num() == 1 && InternalWebSocket && InternalWebSocket->IsConnected())
+			InternalWebSocket->Send(FString::Printf(TEXT("%s%s %lld"), PongPrefix, *Fields[0], Now));
+
+		return true;
+	}
+
+	if (bPingEnabled && Fields.Num() == 2)
+	{
+		const int64 SentMicros = FCString::Atoi64(*Fields[0]);
+		const int64 PeerMicros = FCString::Atoi64(*Fields[1]);
+		const int64 RttMicros = Now - SentMicros;
+
+		if (RttMicros >= 0)
+			TimingStats.AddSample(RttMicros, PeerMicros + RttMicros / 2 - Now);
+	}
+
+	return true;
+}
+
+FNetTimingStats UWebSocket::GetTimingStats() const
+{
+	return TimingStats;
+}
+
+float UWebSocket::GetSmoothedRttMs() const
+{
+	return TimingStats.SmoothedRttMs;
+}
+
+int64 UWebSocket::GetServerTimeMicroseconds() const
+{
+	return UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds() + static_cast<int64>(TimingStats.ServerClockOffsetMs * 1000.0);
 }
 
 void UWebSocket::OnWebSocketConnected_Internal()
 {
+	ResetStringTables();
 	OnWebSocketConnected.Broadcast();
 }
 
 void UWebSocket::OnWebSocketConnectionError_Internal(const FString& Error)
 {
+	if (PacketJournal)
+		PacketJournal->Dump(*FString::Printf(TEXT("connection error: %s"), *Error));
+
 	OnWebSocketConnectionError.Broadcast(Error);
 }
 
 void UWebSocket::OnWebSocketClosed_Internal(int32 StatusCode, const FString& Reason, bool bWasClean)
 {
+	if (PacketJournal && !bWasClean)
+		PacketJournal->Dump(*FString::Printf(TEXT("closed with status %d: %s"), StatusCode, *Reason));
+
+	ResetStringTables();
 	OnWebSocketClosed.Broadcast(StatusCode, Reason, bWasClean);
 }
 
 void UWebSocket::OnWebSocketMessageReceived_Internal(const FString& Message)
 {
+	if (HandleTimingMessage(Message))
+		return;
+
 	OnWebSocketMessageReceived.Broadcast(Message);
 }
 
 void UWebSocket::OnWebSocketBinaryMessageReceived_Internal(const void* Data, SIZE_T Size, bool bIsBinary)
 {
-	TArray<uint8> ByteArray;
 	const uint8* ByteData = static_cast<const uint8*>(Data);
+	const bool bEncrypted = !InboundKey.IsEmpty();
+
+	// The first byte of an encrypted frame is the type XORed with the first key character.
+	uint8 PacketType = 0;
+	if (Size > 0)
+		PacketType = bEncrypted ? ByteData[0] ^ static_cast<uint8>(InboundKey[0]) : ByteData[0];
+
+	if (CaptureWriter)
+		CaptureWriter->Record(ETrafficDirection::Inbound, PacketType, ByteData, static_cast<int32>(Size), bEncrypted);
 
-	for (SIZE_T i = 0; i < Size; ++i)	
-		ByteArray.Add(ByteData[i]);	
+	if (PacketJournal)
+		PacketJournal->Record(ETrafficDirection::Inbound, PacketType, TArrayView<const uint8>(ByteData, static_cast<int32>(Size)));
 
-	//LogByteArray(ByteArray);
+	if (FPacketLog::IsEnabled())
+		FPacketLog::LogPacket(ETrafficDirection::Inbound, PacketType, TArrayView<const uint8>(ByteData, static_cast<int32>(Size)));
+
+	DispatchBinaryMessage(ByteData, static_cast<int32>(Size));
+}
+
+UByteStreamWriter* UWebSocket::OpenStream(uint8 InStreamPacketType, int32 ChunkSize, const FString& Key)
+{
+	UByteStreamWriter* Writer = NewObject<UByteStreamWriter>(this);
+	Writer->Initialize(this, Key, InStreamPacketType, NextStreamId++, ChunkSize);
+	return Writer;
+}
+
+void UWebSocket::EnableStreamReceive(uint8 InStreamPacketType, bool bReassemble, int32 InMaxOpenStreams, int32 InMaxStreamBytes, float IdleTimeoutSeconds)
+{
+	bStreamReceiveEnabled = true;
+	bReassembleStreams = bReassemble;
+	StreamPacketType = InStreamPacketType;
+	MaxOpenStreams = FMath::Max(InMaxOpenStreams, 1);
+	MaxStreamBytes = FMath::Max(InMaxStreamBytes, 0);
+	StreamIdleTimeoutMicros = static_cast<int64>(FMath::Max(IdleTimeoutSeconds, 0.0f) * 1000000.0f);
+	StreamAssemblies.Reset();
+}
+
+void UWebSocket::DisableStreamReceive()
+{
+	bStreamReceiveEnabled = false;
+	StreamAssemblies.Reset();
+}
+
+bool UWebSocket::HandleStreamPacket(const uint8* Data, int32 Size)
+{
+	if (!bStreamReceiveEnabled || Size < 1 + FByteStreamHeader::Size || Data[0] != StreamPacketType)
+		return false;
+
+	FByteStreamHeader Header;
+	FByteStreamHeader::Parse(Data + 1, Size - 1, Header);
+
+	const uint8* Payload = Data + 1 + FByteStreamHeader::Size;
+	const int32 PayloadSize = Size - 1 - FByteStreamHeader::Size;
+	const bool bLast = (Header.Flags & FByteStreamHeader::LastChunkFlag) != 0;
+
+	if (OnStreamChunkReceived.IsBound())
+		OnStreamChunkReceived.Broadcast(static_cast<int32>(Header.StreamId), static_cast<int32>(Header.Sequence), UByteBuffer::CreateByteBufferFromBytes(Payload, PayloadSize), bLast);
+
+	if (!bReassembleStreams)
+		return true;
+
+	const int64 Now = UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds();
+
+	if (!StreamAssemblies.Contains(Header.StreamId) && StreamAssemblies.Num() >= MaxOpenStreams)
+	{
+		uint32 Oldest = 0;
+		int64 OldestMicros = MAX_int64;
+
+		for (const TPair<uint32, TSharedPtr<FByteStreamAssembly>>& Pair : StreamAssemblies)
+		{
+			if (Pair.Value->LastActivityMicros < OldestMicros)
+			{
+				Oldest = Pair.Key;
+				OldestMicros = Pair.Value->LastActivityMicros;
+			}
+		}
+
+		UE_LOG(LogTemp, Warning, TEXT("Too many open streams (%d); dropping stream %u"), StreamAssemblies.Num(), Oldest);
+		StreamAssemblies.Remove(Oldest);
+	}
+
+	TSharedPtr<FByteStreamAssembly>& Assembly = StreamAssemblies.FindOrAdd(Header.StreamId);
+
+	if (!Assembly)
+		Assembly = MakeShared<FByteStreamAssembly>();
+
+	if (Header.Sequence != Assembly->NextSequence)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Stream %u: expected chunk %u, got %u; dropping stream"), Header.StreamId, Assembly->NextSequence, Header.Sequence);
+		StreamAssemblies.Remove(Header.StreamId);
+		return true;
+	}
+
+	if (Assembly->Data.Num() + PayloadSize > MaxStreamBytes)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Stream %u exceeds %d bytes; dropping stream"), Header.StreamId, MaxStreamBytes);
+		StreamAssemblies.Remove(Header.StreamId);
+		return true;
+	}
+
+	Assembly->Data.Append(Payload, PayloadSize);
+	Assembly->LastActivityMicros = Now;
+	++Assembly->NextSequence;
+
+	if (bLast)
+	{
+		UByteBuffer* Result = UByteBuffer::CreateByteBufferWithCapacity(0);
+		Result->GetBuffer() = MoveTemp(Assembly->Data);
+		StreamAssemblies.Remove(Header.StreamId);
+
+		OnStreamCompleted.Broadcast(static_cast<int32>(Header.StreamId), Result);
+	}
+
+	return true;
+}
+
+bool UWebSocket::HandleEncryptedStreamPacket(const uint8* Data, int32 Size)
+{
+	if (!bStreamReceiveEnabled || Size < 1 + FByteStreamHeader::Size || (Data[0] ^ static_cast<uint8>(InboundKey[0])) != StreamPacketType)
+		return false;
+
+	TArray<uint8> Frame = FByteBufferPool::Get().Acquire(Size);
+	Frame.SetNumUninitialized(Size);
+	UEncryption::EncryptInto(TArrayView<const uint8>(Data, Size), InboundKey, Frame);
+
+	const bool bHandled = HandleStreamPacket(Frame.GetData(), Frame.Num());
+	FByteBufferPool::Get().Release(MoveTemp(Frame));
+	return bHandled;
+}
+
+void UWebSocket::EvictStreamAssemblies(int64 Now)
+{
+	for (auto It = StreamAssemblies.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value()->LastActivityMicros > StreamIdleTimeoutMicros)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Stream %u idle for too long; dropping stream"), It.Key());
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UWebSocket::InjectBinaryMessage(const uint8* Data, int32 Size)
+{
+	DispatchBinaryMessage(Data, Size);
+}
+
+void UWebSocket::DispatchBinaryMessage(const uint8* Data, int32 Size)
+{
+	const bool bEncrypted = !InboundKey.IsEmpty();
+	const uint8 PacketType = Size > 0 ? (bEncrypted ? Data[0] ^ static_cast<uint8>(InboundKey[0]) : Data[0]) : 0;
+
+	// The compressed and combined types are only checked on plaintext, so ciphertext that happens to start with
+	// them is left alone.
+	const bool bCompressed = bCompressionEnabled && Size > 0 && PacketType == CompressedPacketType;
+	const bool bCombined = bCompressionEnabled && bCombinedCompressionEnabled && Size > 0 && PacketType == CombinedPacketType;
+
+	if (!bCompressed && !bCombined)
+	{
+		DeliverBinaryMessage(Data, Size);
+		return;
+	}
+
+	TArray<uint8> Plain;
+	TArray<uint8> Frame;
+
+	if (bEncrypted)
+	{
+		Plain = FByteBufferPool::Get().Acquire(Size);
+		Plain.SetNumUninitialized(Size);
+		UEncryption::EncryptInto(TArrayView<const uint8>(Data, Size), InboundKey, Plain);
+	}
+
+	const uint8* PlainData = bEncrypted ? Plain.GetData() : Data;
+	bool bExpanded = bCompressed ? DecompressFrame(PlainData, Size, Frame) : ExpandCombinedFrame(PlainData, Size, Frame);
+
+	// A combined frame compressed as a whole may still hold compressed sub-packets.
+	if (bCompressed && bExpanded && bCombinedCompressionEnabled && Frame[0] == CombinedPacketType)
+	{
+		TArray<uint8> Combined;
+
+		if (ExpandCombinedFrame(Frame.GetData(), Frame.Num(), Combined))
+			Swap(Frame, Combined);
+
+		FByteBufferPool::Get().Release(MoveTemp(Combined));
+	}
+
+	FByteBufferPool::Get().Release(MoveTemp(Plain));
+
+	// The expanded frame is handed on encrypted again, exactly as the peer would have sent it uncompressed.
+	if (bExpanded)
+	{
+		if (bEncrypted)
+			UEncryption::EncryptBufferInPlace(Frame, InboundKey);
+
+		DeliverBinaryMessage(Frame.GetData(), Frame.Num());
+		FByteBufferPool::Get().Release(MoveTemp(Frame));
+		return;
+	}
+
+	FByteBufferPool::Get().Release(MoveTemp(Frame));
+	DeliverBinaryMessage(Data, Size);
+}
+
+void UWebSocket::DeliverBinaryMessage(const uint8* Data, int32 Size)
+{
+	if (InboundKey.IsEmpty() ? HandleStreamPacket(Data, Size) : HandleEncryptedStreamPacket(Data, Size))
+		return;
+
+	UByteBuffer* Buffer = UByteBuffer::CreateByteBufferFromBytes(Data, Size);
+
+	//LogByteArray(Buffer->GetBuffer());
 
-	UByteBuffer* Buffer = UByteBuffer::CreateByteBuffer(ByteArray);
 	OnWebSocketBinaryMessageReceived.Broadcast(Buffer);
 }
 
 void UWebSocket::OnWebSocketMessageSent_Internal(const FString& Message)
 {
+	if (IsTimingMessage(Message))
+		return;
+
 	OnWebSocketMessageSent.Broadcast(Message);
 }
 
@@ -116,18 +943,78 @@ UWebSocket* UWebSocketFunctionLibrary::CreateWebSocket(FString ServerUrl, FStrin
 	return CreateWebSocketWithHeaders(ServerUrl, {}, ServerProtocol);
 }
 
+static FWebSocketTransportFactory GTransportFactory;
+
 UWebSocket* UWebSocketFunctionLibrary::CreateWebSocketWithHeaders(FString ServerUrl, TMap<FString, FString> UpgradeHeaders, FString ServerProtocol /* = TEXT("ws") */)
 {
-	const TSharedPtr<IWebSocket> ActualSocket = FModuleManager::LoadModuleChecked<FWebSocketsModule>(TEXT("WebSockets")).CreateWebSocket(ServerUrl, ServerProtocol, UpgradeHeaders);
+	const TSharedPtr<IWebSocket> ActualSocket = GTransportFactory
+		? GTransportFactory(ServerUrl, ServerProtocol, UpgradeHeaders)
+		: FModuleManager::LoadModuleChecked<FWebSocketsModule>(TEXT("WebSockets")).CreateWebSocket(ServerUrl, ServerProtocol, UpgradeHeaders);
 	UWebSocket* const WrapperSocket = NewObject<UWebSocket>();
 	WrapperSocket->InitWebSocket(ActualSocket);
 	return WrapperSocket;
 }
 
+UWebSocket* UWebSocketFunctionLibrary::CreateLoopbackWebSocket()
+{
+	UWebSocket* const WrapperSocket = NewObject<UWebSocket>();
+	WrapperSocket->InitWebSocket(FLoopbackWebSocket::CreateEcho());
+	return WrapperSocket;
+}
+
+void UWebSocketFunctionLibrary::CreateLoopbackWebSocketPair(UWebSocket*& OutClient, UWebSocket*& OutServer)
+{
+	TSharedPtr<FLoopbackWebSocket> Client;
+	TSharedPtr<FLoopbackWebSocket> Server;
+	FLoopbackWebSocket::CreatePair(Client, Server);
+
+	OutClient = NewObject<UWebSocket>();
+	OutClient->InitWebSocket(Client);
+
+	OutServer = NewObject<UWebSocket>();
+	OutServer->InitWebSocket(Server);
+}
+
+int32 UWebSocketFunctionLibrary::PumpLoopbackWebSockets()
+{
+	return FLoopbackWebSocket::PumpAll();
+}
+
+void UWebSocketFunctionLibrary::UseLoopbackTransport(bool bEnabled)
+{
+	if (bEnabled)
+	{
+		SetTransportFactory([](const FString&, const FString&, const TMap<FString, FString>&) -> TSharedPtr<IWebSocket>
+		{
+			return FLoopbackWebSocket::CreateEcho();
+		});
+	}
+	else
+	{
+		SetTransportFactory(nullptr);
+	}
+}
+
+void UWebSocketFunctionLibrary::SetTransportFactory(FWebSocketTransportFactory Factory)
+{
+	GTransportFactory = MoveTemp(Factory);
+}
+
 int32 UWebSocketFunctionLibrary::GetTimeInMilliseconds()
 {
 	FDateTime Now = FDateTime::Now();
 	FTimespan Timespan = Now.GetTimeOfDay();
 	int64 Milliseconds = Timespan.GetTotalMilliseconds();
 	return Milliseconds;
+}
+
+int64 UWebSocketFunctionLibrary::GetMonotonicTimeMicroseconds()
+{
+	static const uint64 BaseCycles = FPlatformTime::Cycles64();
+	return static_cast<int64>((FPlatformTime::Cycles64() - BaseCycles) * FPlatformTime::GetSecondsPerCycle64() * 1000000.0);
+}
+
+int64 UWebSocketFunctionLibrary::GetMonotonicTimeMilliseconds()
+{
+	return GetMonotonicTimeMicroseconds() / 1000;
 }
\ No newline at end of file
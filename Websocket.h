@@ -2,12 +2,20 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
+#include "HAL/CriticalSection.h"
 #include "ByteBuffer.h"
 #include "Modules/ModuleManager.h"
+#include <atomic>
 
 #include "Websocket.generated.h"
 
 class IWebSocket;
+class FTrafficCaptureWriter;
+class FPacketJournal;
+class UByteStreamWriter;
+struct FByteStreamAssembly;
+class FPacketDictionary;
+class FNetStringTable;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnWebSocketConnected);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWebSocketConnectionError, const FString&, Error);
@@ -15,6 +23,70 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnWebSocketClosed, int32, Status
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWebSocketMessageReceived, const FString&, Message);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWebSocketBinaryMessageReceived, UByteBuffer*, Data);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWebSocketMessageSent, const FString&, Message);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FOnStreamChunkReceived, int32, StreamId, int32, Sequence, UByteBuffer*, Chunk, bool, bLast);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnStreamCompleted, int32, StreamId, UByteBuffer*, Payload);
+
+USTRUCT(BlueprintType)
+struct FNetTimingStats
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadOnly, Category = "WebSockets")
+	float SmoothedRttMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "WebSockets")
+	float JitterMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "WebSockets")
+	float MinRttMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "WebSockets")
+	float LastRttMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "WebSockets")
+	float ServerClockOffsetMs = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "WebSockets")
+	int32 SampleCount = 0;
+
+	void AddSample(int64 RttMicros, int64 ClockOffsetMicros);
+};
+
+USTRUCT(BlueprintType)
+struct FPacketSchemaDefinition
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSockets")
+	uint8 PacketType = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSockets")
+	TMap<FString, FString> DataSequence;
+};
+
+USTRUCT(BlueprintType)
+struct FNetWarmupProfile
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSockets")
+	TArray<FPacketSchemaDefinition> Schemas;
+
+	// Expected peak of packets handled in one frame, e.g. during the initial world sync.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSockets")
+	int32 PacketsPerFrame = 128;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSockets")
+	int32 AveragePacketSize = 256;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "WebSockets")
+	int32 MaxPacketSize = 16384;
+};
+
+typedef TFunction<TSharedPtr<IWebSocket>(const FString& ServerUrl, const FString& ServerProtocol, const TMap<FString, FString>& UpgradeHeaders)> FWebSocketTransportFactory;
 
 UCLASS(MinimalAPI, BlueprintType)
 class UWebSocket final : public UObject
@@ -40,7 +112,34 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnWebSocketMessageSent OnWebSocketMessageSent;
 
+	UPROPERTY(BlueprintAssignable)
+	FOnStreamChunkReceived OnStreamChunkReceived;
+
+	// Only broadcast while stream reassembly is enabled.
+	UPROPERTY(BlueprintAssignable)
+	FOnStreamCompleted OnStreamCompleted;
+
 	void InitWebSocket(TSharedPtr<IWebSocket> InWebSocket);
+	TSharedPtr<IWebSocket> GetTransport() const { return InternalWebSocket; }
+
+	// Sends a finished frame and records it in the capture, journal and packet log. PacketType is the plaintext
+	// type. When Frame is compressed, CaptureFrame may hold the frame it replaced, encrypted the same way, and
+	// the capture records that under CapturePacketType instead, so dictionaries can be trained from captures
+	// of compressed sessions. Safe to call from any thread as long as the transport's Send is.
+	void SendFrame(uint8 PacketType, const TArray<uint8>& Frame, bool bEncrypted = false, uint8 CapturePacketType = 0, TArrayView<const uint8> CaptureFrame = TArrayView<const uint8>());
+
+	// Builds the uncompressed frame SendFrame's capture wants, if a capture is running and BuildFrame turned
+	// the packet into WirePacketType; returns false when there is nothing to build.
+	bool BuildCaptureFrame(uint8 PacketType, uint8 WirePacketType, TArrayView<const uint8> Payload, const FString& Key, TArray<uint8>& OutFrame) const;
+
+	// Frames Payload as PacketType, compressing it when compression is enabled and the type has a dictionary,
+	// and returns the type the frame goes out as. Reads the compression settings without a lock, so other
+	// threads may only call it once compression and its dictionaries are set up.
+	uint8 BuildFrame(uint8 PacketType, TArrayView<const uint8> Payload, TArray<uint8>& OutFrame) const;
+
+	// Appends a sub-packet to a combined frame of CombinedType, compressed with its own type's dictionary when
+	// combined compression is enabled for that type and it comes out smaller. Same threading rule as BuildFrame.
+	void AppendCombinedPacket(TArray<uint8>& Frame, uint8 CombinedType, uint8 PacketType, TArrayView<const uint8> Payload) const;
 
 	UFUNCTION(BlueprintCallable, Category = "WebSockets")
 	void Connect();
@@ -57,6 +156,124 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "WebSockets")
 	void SendEncryptedMessage(uint8 PacketType, UByteBuffer* Message, const FString& Key);
 
+	// Key the peer encrypts its frames with, used to recover their packet type for capture and logging.
+	// Leave empty when the peer sends plaintext.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void SetInboundKey(const FString& Key);
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	bool StartCapture(const FString& FilePath);
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void StopCapture();
+
+	UFUNCTION(BlueprintPure, Category = "WebSockets")
+	bool IsCapturing() const;
+
+	// Keeps the last packets in each direction and dumps them on a connection error or unclean close.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void EnablePacketJournal(int32 EntriesPerDirection = 64);
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void DisablePacketJournal();
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void DumpPacketJournal(const FString& Reason) const;
+
+	// Runs a frame through the same receive path as the socket does, minus capture, journal and logging.
+	void InjectBinaryMessage(const uint8* Data, int32 Size);
+
+	// Both peers must enable interning with the same capacity before exchanging interned strings.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void EnableStringInterning(int32 Capacity = 1024);
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void DisableStringInterning();
+
+	UFUNCTION(BlueprintPure, Category = "WebSockets")
+	bool IsStringInterningEnabled() const;
+
+	TSharedPtr<FNetStringTable> GetOutgoingStringTable() const;
+	TSharedPtr<FNetStringTable> GetIncomingStringTable() const;
+
+	// Resolves Message's interned strings against the outgoing table right before it is sent.
+	void CommitInternedStrings(UByteBuffer* Message);
+
+	// Pings carry the local send time; the peer answers with a pong echoing it plus its own clock. Both travel
+	// as reserved text frames, apart from the binary packet stream, so they are never encrypted or mistaken
+	// for packets. Pings are always answered, and neither is broadcast.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void EnablePing(float IntervalSeconds = 1.0f);
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void DisablePing();
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void Tick();
+
+	UFUNCTION(BlueprintPure, Category = "WebSockets")
+	FNetTimingStats GetTimingStats() const;
+
+	UFUNCTION(BlueprintPure, Category = "WebSockets")
+	float GetSmoothedRttMs() const;
+
+	UFUNCTION(BlueprintPure, Category = "WebSockets")
+	int64 GetServerTimeMicroseconds() const;
+
+	const FNetTimingStats& GetTimingStatsRef() const { return TimingStats; }
+
+	// Chunks are sent straight to the socket as standalone frames, encrypted with Key when one is given, and
+	// bypass any queue's pacing; UQueueBuffer::OpenStream opens a stream that is paced with its queue.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	UByteStreamWriter* OpenStream(uint8 StreamPacketType, int32 ChunkSize = 16384, const FString& Key = TEXT(""));
+
+	// Stream chunks of this type are consumed here, decrypted with the inbound key when one is set, and surfaced
+	// through OnStreamChunkReceived, and through OnStreamCompleted when bReassemble is set. Reassembly drops
+	// streams that grow past MaxStreamBytes or stay idle for IdleTimeoutSeconds (checked in Tick), and evicts
+	// the least recently active stream when more than MaxOpenStreams are open.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void EnableStreamReceive(uint8 InStreamPacketType, bool bReassemble = true, int32 InMaxOpenStreams = 16, int32 InMaxStreamBytes = 16777216, float IdleTimeoutSeconds = 30.0f);
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void DisableStreamReceive();
+
+	// Packets whose type has a dictionary are sent as InCompressedPacketType frames whenever that is smaller.
+	// Compression looks at the frame's own type, so packets combined by a UQueueBuffer are only compressed as a
+	// whole if the queue packet type has a dictionary, or one by one with EnableCombinedPacketCompression.
+	// Both peers must enable compression with the same type and register the same dictionaries. When the peer
+	// encrypts, set its key with SetInboundKey so compressed frames can be recognized and expanded.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void EnablePacketCompression(uint8 InCompressedPacketType);
+
+	// Also disables combined packet compression.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void DisablePacketCompression();
+
+	// Sub-packets of combined frames of this type are compressed one by one with their own type's dictionary,
+	// and expanded again before the combined frame is dispatched, so receivers split it as usual. Compressed
+	// sub-packets carry their size, which makes the compressed packet type reserved inside such frames. Needs
+	// EnablePacketCompression, and both peers must use the same combined packet type.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void EnableCombinedPacketCompression(uint8 InCombinedPacketType);
+
+	// The most recently added dictionary of a packet type is used for sending; every added dictionary
+	// stays available for receiving, so dictionaries can be rolled out under new ids.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	bool LoadCompressionDictionary(const FString& FilePath);
+
+	void AddCompressionDictionary(TSharedPtr<const FPacketDictionary> Dictionary);
+
+	// Compressed frames are expanded before dispatch, except when they were encrypted and no inbound key is
+	// set; those can be expanded here after decryption. Returns nullptr if Packet is not a valid compressed frame.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	UByteBuffer* DecompressPacket(UByteBuffer* Packet);
+
+	// Compiles the profile's schemas into the shared schema cache, fills the buffer pool for the expected
+	// traffic and runs each schema once through encode, decode and compression, so the first real frames
+	// do not pay for any of it. Call it before Connect.
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	void WarmUp(const FNetWarmupProfile& Profile);
+
 private:
 
 	UFUNCTION()
@@ -76,7 +293,53 @@ private:
 	UFUNCTION()
 	void OnWebSocketMessageSent_Internal(const FString& Message);
 
+	void DispatchBinaryMessage(const uint8* Data, int32 Size);
+	void DeliverBinaryMessage(const uint8* Data, int32 Size);
+	void ResetStringTables();
+
+	void SendPing();
+	bool HandleTimingMessage(const FString& Message);
+	bool HandleStreamPacket(const uint8* Data, int32 Size);
+	bool HandleEncryptedStreamPacket(const uint8* Data, int32 Size);
+	void EvictStreamAssemblies(int64 Now);
+
+	bool ReadCompressedHeader(const uint8* Body, int32 Size, int32& OutOffset, uint32& OutRawSize, const FPacketDictionary*& OutDictionary) const;
+	bool DecompressFrame(const uint8* Data, int32 Size, TArray<uint8>& OutFrame) const;
+	// Returns false if the frame holds no compressed sub-packets or one of them is malformed.
+	bool ExpandCombinedFrame(const uint8* Data, int32 Size, TArray<uint8>& OutFrame) const;
+
 	TSharedPtr<IWebSocket> InternalWebSocket;
+	// Guards swapping the capture writer and journal against SendFrame on other threads.
+	FCriticalSection DiagnosticsLock;
+	TSharedPtr<FTrafficCaptureWriter> CaptureWriter;
+	TSharedPtr<FPacketJournal> PacketJournal;
+	// Set while either of the two is, so SendFrame only takes the lock when there is something to record.
+	std::atomic<bool> bHasDiagnostics { false };
+	std::atomic<bool> bCapturing { false };
+	FString InboundKey;
+	TSharedPtr<FNetStringTable> OutgoingStrings;
+	TSharedPtr<FNetStringTable> IncomingStrings;
+
+	bool bPingEnabled = false;
+	int64 PingIntervalMicros = 0;
+	int64 LastPingMicros = 0;
+	FNetTimingStats TimingStats;
+
+	uint32 NextStreamId = 1;
+	bool bStreamReceiveEnabled = false;
+	bool bReassembleStreams = false;
+	uint8 StreamPacketType = 0;
+	int32 MaxOpenStreams = 0;
+	int32 MaxStreamBytes = 0;
+	int64 StreamIdleTimeoutMicros = 0;
+	TMap<uint32, TSharedPtr<FByteStreamAssembly>> StreamAssemblies;
+
+	bool bCompressionEnabled = false;
+	uint8 CompressedPacketType = 0;
+	bool bCombinedCompressionEnabled = false;
+	uint8 CombinedPacketType = 0;
+	TMap<uint8, TSharedPtr<const FPacketDictionary>> SendDictionaries;
+	TMap<uint16, TSharedPtr<const FPacketDictionary>> ReceiveDictionaries;
 };
 
 
@@ -93,6 +356,27 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "WebSockets")
 	static UWebSocket* CreateWebSocketWithHeaders(FString ServerUrl, TMap<FString, FString> UpgradeHeaders, FString ServerProtocol = TEXT("ws"));
 
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	static UWebSocket* CreateLoopbackWebSocket();
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	static void CreateLoopbackWebSocketPair(UWebSocket*& OutClient, UWebSocket*& OutServer);
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	static int32 PumpLoopbackWebSockets();
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	static void UseLoopbackTransport(bool bEnabled);
+
+	static void SetTransportFactory(FWebSocketTransportFactory Factory);
+
+	// Wall-clock time of day; use the monotonic variants for latency measurements.
 	UFUNCTION(BlueprintCallable, Category = "WebSockets")
 	static int32 GetTimeInMilliseconds();
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	static int64 GetMonotonicTimeMicroseconds();
+
+	UFUNCTION(BlueprintCallable, Category = "WebSockets")
+	static int64 GetMonotonicTimeMilliseconds();
 };
\ No newline at end of file